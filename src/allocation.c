@@ -0,0 +1,171 @@
+#include "q1.h"
+
+/*
+ * Allocation policies for renting cars.
+ * The mileage policy rents the head of the available list, which is already sorted by mileage.
+ * The other policies keep a binary min-heap of the available cars, so choosing a car is O(log n).
+ */
+
+/*
+ * Converts a policy name into an allocation policy.
+ *
+ * @param name: The name given on the command line.
+ * @param policy: Receives the parsed policy.
+ * @return: Returns true if the name is a known policy, false otherwise.
+ */
+bool parse_allocation_policy(const char *name, enum allocation_policy *policy) {
+    if (strcmp(name, "mileage") == 0) {
+        *policy = POLICY_MILEAGE;
+    } else if (strcmp(name, "round-robin") == 0) {
+        *policy = POLICY_ROUND_ROBIN;
+    } else if (strcmp(name, "least-recent") == 0) {
+        *policy = POLICY_LEAST_RECENT;
+    } else {
+        return false; // Unknown policy name
+    }
+    return true;
+}
+
+// Returns true if heap entry 'a' should be rented before entry 'b'
+static bool entry_before(const struct allocation_entry *a, const struct allocation_entry *b) {
+    if (a->key != b->key) return a->key < b->key;
+    return a->seq < b->seq;
+}
+
+// Swaps two heap entries
+static void swap_entries(struct allocation_entry *a, struct allocation_entry *b) {
+    struct allocation_entry temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+/*
+ * Sets up an allocator and indexes the cars already on the available list.
+ *
+ * @param alloc: The allocator to initialize.
+ * @param policy: The policy used to choose cars.
+ * @param available_head: Pointer to the head of the available list.
+ * @return: Returns true on success, false if the heap could not grow (the allocator is left empty).
+ */
+bool allocator_init(struct allocator *alloc, enum allocation_policy policy, struct car *available_head) {
+    alloc->policy = policy;
+    alloc->heap = NULL;
+    alloc->size = 0;
+    alloc->capacity = 0;
+    alloc->clock = 0;
+
+    // Index the cars loaded from the file in list order
+    for (struct car *current = available_head; current != NULL; current = current->next) {
+        if (!allocator_add(alloc, current)) {
+            allocator_free(alloc); // A partial index would hide cars from the policy
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Adds a newly available car to the allocator's heap.
+ * The car's key is its arrival order for round-robin, or its last rental for least-recently-rented.
+ *
+ * @param alloc: The allocator.
+ * @param car: The new node on the available list.
+ * @return: Returns true on success, false if the heap could not grow.
+ */
+bool allocator_add(struct allocator *alloc, struct car *car) {
+    if (car == NULL) return true;
+    alloc->clock++;
+    if (alloc->policy == POLICY_MILEAGE) return true; // The sorted list is the index
+
+    // Grow the heap when it is full
+    if (alloc->size == alloc->capacity) {
+        int capacity = alloc->capacity == 0 ? 16 : alloc->capacity * 2;
+        struct allocation_entry *heap = realloc(alloc->heap, capacity * sizeof(struct allocation_entry));
+        if (heap == NULL) return false; // Handle memory allocation failure
+        alloc->heap = heap;
+        alloc->capacity = capacity;
+    }
+
+    // Place the entry at the end and sift it up to its position
+    int i = alloc->size++;
+    alloc->heap[i].car = car;
+    alloc->heap[i].seq = alloc->clock;
+    alloc->heap[i].key = alloc->policy == POLICY_ROUND_ROBIN ? alloc->clock : car->last_rented;
+    while (i > 0 && entry_before(&alloc->heap[i], &alloc->heap[(i - 1) / 2])) {
+        swap_entries(&alloc->heap[i], &alloc->heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    return true;
+}
+
+/*
+ * Chooses the next car to rent. The car stays on the available list; the caller unlinks it
+ * with unlink_car(), which uses the car's 'prev' link instead of searching the list, and then
+ * records the rental with allocator_rented().
+ *
+ * @param alloc: The allocator.
+ * @param available_head: Pointer to the head of the available list.
+ * @return: Returns the chosen car, or NULL if the list is empty.
+ */
+struct car *allocator_pick(struct allocator *alloc, struct car *available_head) {
+    struct car *chosen;
+
+    if (alloc->policy == POLICY_MILEAGE) {
+        chosen = available_head; // The list is sorted by mileage
+    } else {
+        if (alloc->size == 0) return NULL; // No cars available
+
+        // Take the root of the heap and sift the last entry down into its place
+        chosen = alloc->heap[0].car;
+        alloc->heap[0] = alloc->heap[--alloc->size];
+        int i = 0;
+        while (1) {
+            int smallest = i;
+            int left = 2 * i + 1;
+            int right = 2 * i + 2;
+            if (left < alloc->size && entry_before(&alloc->heap[left], &alloc->heap[smallest])) smallest = left;
+            if (right < alloc->size && entry_before(&alloc->heap[right], &alloc->heap[smallest])) smallest = right;
+            if (smallest == i) break;
+            swap_entries(&alloc->heap[i], &alloc->heap[smallest]);
+            i = smallest;
+        }
+    }
+
+    return chosen;
+}
+
+/*
+ * Records that a car was rented out, for the least-recently-rented policy.
+ * Called after the car is taken off the available list, so a running snapshot keeps its old value.
+ *
+ * @param alloc: The allocator.
+ * @param car: The car that was rented out.
+ */
+void allocator_rented(struct allocator *alloc, struct car *car) {
+    car->last_rented = ++alloc->clock;
+}
+
+/*
+ * Moves the allocator's clock past the last rental of every car loaded from the files,
+ * so cars rented from now on count as rented after them.
+ *
+ * @param alloc: The allocator.
+ * @param head: Pointer to the head of a loaded list.
+ */
+void allocator_restore_clock(struct allocator *alloc, struct car *head) {
+    for (struct car *current = head; current != NULL; current = current->next) {
+        if (current->last_rented > alloc->clock) alloc->clock = current->last_rented;
+    }
+}
+
+/*
+ * Frees the allocator's heap. The cars belong to the lists and are freed by free_list().
+ *
+ * @param alloc: The allocator.
+ */
+void allocator_free(struct allocator *alloc) {
+    free(alloc->heap);
+    alloc->heap = NULL;
+    alloc->size = 0;
+    alloc->capacity = 0;
+}
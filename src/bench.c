@@ -0,0 +1,160 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime()
+#include "q1.h"
+#include <time.h>
+
+/*
+ * Benchmark for the fleet command API.
+ * Builds a fleet in memory (no files are read or written) and times renting, returning and
+ * transferring the same number of cars one command at a time and as batches. The single commands
+ * walk a list for every car; the batch commands walk each list once.
+ *
+ * Usage: ./car_rental_bench [cars] [batch size] [policy]
+ */
+
+// Returns the current time in seconds
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/*
+ * Checks that every list is linked both ways and in the order insert_to_list() keeps.
+ *
+ * @param head: Pointer to the head of the list.
+ * @param by_date: True if the list is sorted by return date, false if by mileage.
+ * @return: Returns the number of cars on the list, or -1 if the list is broken.
+ */
+static int check_list(struct car *head, bool by_date) {
+    int count = 0;
+    for (struct car *current = head; current != NULL; current = current->next, count++) {
+        if (current->next == NULL) continue;
+        if (current->next->prev != current) return -1;
+        if (by_date ? current->next->return_date < current->return_date : current->next->mileage < current->mileage) return -1;
+    }
+    return count;
+}
+
+/*
+ * Rents 'count' cars, then returns them (every tenth one to the repair list) and transfers the
+ * repaired ones back, either one command at a time or as three batches.
+ *
+ * @param fleet: The fleet.
+ * @param count: The number of cars to rent.
+ * @param batch: True to use the batch commands.
+ * @param seconds: Receives the time taken by the rentals, returns and transfers.
+ * @return: Returns true if every command was applied.
+ */
+static bool run_round(struct fleet *fleet, int count, bool batch, double seconds[3]) {
+    int *dates = malloc(count * sizeof(int));
+    struct rental_outcome *outcomes = malloc(count * sizeof(struct rental_outcome));
+    struct return_request *returns = malloc(count * sizeof(struct return_request));
+    char (*plates)[9] = malloc(count * sizeof(*plates));
+    enum rental_result *results = malloc(count * sizeof(enum rental_result));
+    bool ok = dates != NULL && outcomes != NULL && returns != NULL && plates != NULL && results != NULL;
+
+    int rented = 0;
+    int repaired = 0;
+    if (ok) {
+        for (int i = 0; i < count; i++) {
+            dates[i] = 250101 + i % 28; // Return dates spread over February 2025
+        }
+
+        double start = now();
+        if (batch) {
+            rented = fleet_rent_batch(fleet, dates, count, outcomes);
+        } else {
+            for (int i = 0; i < count; i++) {
+                outcomes[i] = fleet_rent_car(fleet, dates[i]);
+                if (outcomes[i].result == RENTAL_OK) rented++;
+            }
+        }
+        seconds[0] = now() - start;
+
+        // Return the cars in the order they were rented, with a short trip each
+        for (int i = 0; i < rented; i++) {
+            strcpy(returns[i].plate, outcomes[i].plate);
+            returns[i].mileage = outcomes[i].mileage + 50 + i % 300;
+            returns[i].to_repair = i % 10 == 0;
+            if (returns[i].to_repair) strcpy(plates[repaired++], outcomes[i].plate);
+        }
+
+        start = now();
+        int returned = 0;
+        if (batch) {
+            returned = fleet_return_batch(fleet, returns, rented, outcomes);
+        } else {
+            for (int i = 0; i < rented; i++) {
+                outcomes[i] = fleet_return_car(fleet, returns[i].plate, returns[i].mileage, returns[i].to_repair);
+                if (outcomes[i].result == RENTAL_OK) returned++;
+            }
+        }
+        seconds[1] = now() - start;
+
+        start = now();
+        int transferred = 0;
+        if (batch) {
+            transferred = fleet_transfer_batch(fleet, plates, repaired, results);
+        } else {
+            for (int i = 0; i < repaired; i++) {
+                if (fleet_transfer_car(fleet, plates[i]) == RENTAL_OK) transferred++;
+            }
+        }
+        seconds[2] = now() - start;
+
+        ok = rented == count && returned == rented && transferred == repaired;
+    }
+
+    free(dates);
+    free(outcomes);
+    free(returns);
+    free(plates);
+    free(results);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    int cars = argc > 1 ? atoi(argv[1]) : 100000;
+    int count = argc > 2 ? atoi(argv[2]) : 1000;
+    enum allocation_policy policy = POLICY_MILEAGE;
+    if (cars <= 0 || count <= 0 || count > cars || (argc > 3 && !parse_allocation_policy(argv[3], &policy))) {
+        printf("Usage: %s [cars] [batch size] [mileage|round-robin|least-recent]\n", argv[0]);
+        return 1;
+    }
+
+    struct fleet fleet;
+    if (!fleet_init(&fleet, policy)) {
+        printf("Error: Not enough memory to start.\n");
+        return 1;
+    }
+
+    // Add the cars from the highest mileage down, so each one goes to the head of the available list
+    double start = now();
+    for (int i = 0; i < cars; i++) {
+        char plate[9];
+        sprintf(plate, "%06x", (unsigned)i * 2654435761u % 0xFFFFFFu); // Distinct, scattered plates
+        if (fleet_add_car(&fleet, plate, 2 * (cars - i)) != RENTAL_OK) {
+            printf("Error: Could not add car %s.\n", plate);
+            fleet_free(&fleet);
+            return 1;
+        }
+    }
+    printf("Added %d cars in %.1f ms.\n", cars, (now() - start) * 1000);
+
+    double single[3];
+    double batch[3];
+    bool ok = run_round(&fleet, count, false, single);
+    ok = run_round(&fleet, count, true, batch) && ok;
+
+    const char *names[3] = {"Rent", "Return", "Transfer"};
+    printf("%-10s %16s %16s\n", "", "one at a time", "as a batch");
+    for (int i = 0; i < 3; i++) {
+        printf("%-10s %13.2f ms %13.2f ms\n", names[i], single[i] * 1000, batch[i] * 1000);
+    }
+
+    ok = ok && check_list(fleet.available, false) == cars && check_list(fleet.rented, true) == 0 &&
+         check_list(fleet.repair, false) == 0;
+    printf(ok ? "Every command was applied and the lists are in order.\n" : "Error: The fleet is not as expected.\n");
+    fleet_free(&fleet);
+    return ok ? 0 : 1;
+}
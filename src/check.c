@@ -0,0 +1,173 @@
+#include "q1.h"
+
+/*
+ * Checks the plate index against a brute-force search.
+ * Indexes random plates made from a small alphabet, so many plates share prefixes and pairs, removes
+ * some of them, then runs random prefix, substring and one-typo queries and compares every result with
+ * a scan over all the plates.
+ *
+ * Usage: ./car_rental_check [plates] [queries]
+ */
+
+#define CHECK_ALPHABET "ab1z9"     // Characters the random plates and queries are made of
+#define CHECK_REMOVED -1           // Status of a plate that was indexed and then removed
+
+// A plate the check has indexed
+struct check_plate {
+    char plate[7];
+    int status;                    // enum car_status, or CHECK_REMOVED
+};
+
+// Fills 'text' with a random string of 'min' to 6 characters from CHECK_ALPHABET
+static void random_text(char *text, int min) {
+    int length = min + rand() % (7 - min);
+    for (int i = 0; i < length; i++) {
+        text[i] = CHECK_ALPHABET[rand() % (int)strlen(CHECK_ALPHABET)];
+    }
+    text[length] = '\0';
+}
+
+/*
+ * Checks whether two plates are at most one wrong, missing or extra character apart.
+ *
+ * @param a: The first plate.
+ * @param b: The second plate.
+ * @return: Returns true if they are within one edit.
+ */
+static bool within_one_edit(const char *a, const char *b) {
+    int length_a = strlen(a);
+    int length_b = strlen(b);
+    if (length_a == length_b) {
+        int differences = 0;
+        for (int i = 0; i < length_a; i++) {
+            if (a[i] != b[i]) differences++;
+        }
+        return differences <= 1;
+    }
+
+    // Make 'a' the longer plate; it must be 'b' with one extra character
+    if (length_a < length_b) return within_one_edit(b, a);
+    if (length_a != length_b + 1) return false;
+    int i = 0;
+    while (i < length_b && a[i] == b[i]) i++;
+    return strcmp(a + i + 1, b + i) == 0;
+}
+
+// Orders matches by plate
+static int compare_matches(const void *a, const void *b) {
+    return strcmp(((const struct plate_match *)a)->plate, ((const struct plate_match *)b)->plate);
+}
+
+/*
+ * Runs one query against the index and against every plate, and compares the results.
+ *
+ * @param index: The plate index.
+ * @param plates: The indexed plates.
+ * @param count: The number of plates.
+ * @param query: The query.
+ * @param mode: 0 for a prefix search, 1 for a substring search, 2 for a one-typo search.
+ * @param found: Room for 'count' matches from the index.
+ * @param expected: Room for 'count' matches from the scan.
+ * @return: Returns true if both found the same plates with the same status.
+ */
+static bool check_query(struct plate_index *index, struct check_plate *plates, int count, const char *query, int mode,
+                        struct plate_match *found, struct plate_match *expected) {
+    int found_count;
+    if (mode == 0) {
+        found_count = plate_index_prefix(index, query, found, count);
+    } else if (mode == 1) {
+        found_count = plate_index_substring(index, query, found, count);
+    } else {
+        found_count = plate_index_fuzzy(index, query, found, count);
+    }
+
+    int expected_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (plates[i].status == CHECK_REMOVED) continue;
+        bool match;
+        if (mode == 0) {
+            match = strncmp(plates[i].plate, query, strlen(query)) == 0;
+        } else if (mode == 1) {
+            match = strstr(plates[i].plate, query) != NULL;
+        } else {
+            match = within_one_edit(plates[i].plate, query);
+        }
+        if (match) {
+            strcpy(expected[expected_count].plate, plates[i].plate);
+            expected[expected_count].status = (enum car_status)plates[i].status;
+            expected_count++;
+        }
+    }
+
+    if (found_count != expected_count) return false;
+    qsort(found, found_count, sizeof(struct plate_match), compare_matches);
+    qsort(expected, expected_count, sizeof(struct plate_match), compare_matches);
+    for (int i = 0; i < found_count; i++) {
+        if (strcmp(found[i].plate, expected[i].plate) != 0 || found[i].status != expected[i].status) return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 3000;
+    int queries = argc > 2 ? atoi(argv[2]) : 3000;
+    if (count <= 0 || queries <= 0) {
+        printf("Usage: %s [plates] [queries]\n", argv[0]);
+        return 1;
+    }
+
+    struct check_plate *plates = malloc(count * sizeof(struct check_plate));
+    struct plate_match *found = malloc(count * sizeof(struct plate_match));
+    struct plate_match *expected = malloc(count * sizeof(struct plate_match));
+    struct plate_index index;
+    if (plates == NULL || found == NULL || expected == NULL || !plate_index_init(&index)) {
+        printf("Error: Not enough memory to start.\n");
+        free(plates);
+        free(found);
+        free(expected);
+        return 1;
+    }
+    srand(1);
+
+    // Index distinct random plates on random lists, then remove every seventh one
+    int indexed = 0;
+    bool ok = true;
+    for (int i = 0; ok && i < count; i++) {
+        random_text(plates[indexed].plate, 2);
+        if (plate_index_status(&index, plates[indexed].plate) != PLATE_NOT_FOUND) continue; // Already indexed
+        plates[indexed].status = rand() % 3;
+        ok = plate_index_set(&index, plates[indexed].plate, (enum car_status)plates[indexed].status);
+        indexed++;
+    }
+    if (!ok) printf("Error: Not enough memory to index the plates.\n");
+    for (int i = 0; ok && i < indexed; i += 7) {
+        plate_index_remove(&index, plates[i].plate);
+        plates[i].status = CHECK_REMOVED;
+    }
+    for (int i = 0; ok && i < indexed; i++) {
+        int status = plates[i].status == CHECK_REMOVED ? PLATE_NOT_FOUND : plates[i].status;
+        if (plate_index_status(&index, plates[i].plate) != status) {
+            printf("Error: Plate %s has the wrong status.\n", plates[i].plate);
+            ok = false;
+        }
+    }
+
+    const char *modes[3] = {"prefix", "substring", "one-typo"};
+    for (int i = 0; ok && i < queries; i++) {
+        char query[7];
+        random_text(query, 1);
+        for (int mode = 0; ok && mode < 3; mode++) {
+            if (!check_query(&index, plates, indexed, query, mode, found, expected)) {
+                printf("Error: The %s search for '%s' does not match a full scan.\n", modes[mode], query);
+                ok = false;
+            }
+        }
+    }
+
+    if (ok) printf("%d plates and %d queries of each kind match a full scan.\n", indexed, queries);
+    plate_index_free(&index);
+    free(plates);
+    free(found);
+    free(expected);
+    return ok ? 0 : 1;
+}
@@ -5,28 +5,43 @@
  * one for available cars, one for rented cars, and one for cars under repair.
  * The function displays a menu to allow users to add cars, rent cars, return cars,
  * transfer cars between lists, and view the lists.
+ * The transactions themselves are done by the fleet_* functions in rental.c.
  */
 
-int main() {
-    /* Initialize the heads of the three linked lists (all start empty).
-    * 'available_head' stores cars that are available for rent.
-    * 'rented_head' stores cars that are currently rented out.
-    * 'repair_head' stores cars that are under repair.
-    */
-    struct car *available_head = NULL;
-    struct car *rented_head = NULL;
-    struct car *repair_head = NULL;
-    
+int main(int argc, char *argv[]) {
     // Variables to store user inputs (choice from the menu, car details like plate, mileage, return date).
     int choice;
     char plate[9]; // Car plate numbers have a maximum length of 8 characters plus the null terminator.
     int mileage, return_date;
+    struct plate_match matches[10]; // Results of a plate search (case 11)
+    const char *status_names[3] = {"available", "rented", "repair"};
+
+    // Choose the allocation policy used by case 5 (lowest mileage first unless one is given on the command line).
+    enum allocation_policy policy = POLICY_MILEAGE;
+    if (argc > 1 && !parse_allocation_policy(argv[1], &policy)) {
+        printf("Unknown allocation policy '%s'. Use mileage, round-robin or least-recent.\n", argv[1]);
+        return 1;
+    }
+
+    /* Initialize the fleet, which holds the three linked lists:
+    * 'available' stores cars that are available for rent.
+    * 'rented' stores cars that are currently rented out.
+    * 'repair' stores cars that are under repair.
+    */
+    struct fleet fleet;
+    if (!fleet_init(&fleet, policy)) {
+        printf("Error: Not enough memory to start.\n");
+        return 1;
+    }
 
     // Load the initial car data from text files into the corresponding linked lists.
     // Each file (available.txt, rented.txt, repair.txt) contains information about the cars in the respective lists.
-    read_file_into_list("available.txt", &available_head);
-    read_file_into_list("rented.txt", &rented_head);
-    read_file_into_list("repair.txt", &repair_head);
+    if (!fleet_load(&fleet, "available.txt", "rented.txt", "repair.txt")) {
+        // Without a full index the policies and duplicate checks would miss loaded cars
+        printf("Error: Not enough memory to load the fleet.\n");
+        fleet_free(&fleet);
+        return 1;
+    }
 
     // Main loop that continuously displays the menu and processes user input until the user chooses to quit.
     do {
@@ -74,14 +89,17 @@ int main() {
                 continue;
             }
                 
-                // Check if the car's plate number already exists in any of the lists (to prevent duplicates).
-            if (is_plate_in_list(available_head, plate) || is_plate_in_list(rented_head, plate) || is_plate_in_list(repair_head,  plate)) {
-                printf("Error: Duplicate plate number.\n");
-            } else 
-                // If no duplicate is found, insert the new car into the available list.
-            {
-                insert_to_list(&available_head, plate, mileage, -1);
-                printf("New car added to available-for-rent list.\n");
+                // Add the car to the available list (this fails if the plate is already on any of the lists).
+            switch (fleet_add_car(&fleet, plate, mileage)) {
+                case RENTAL_OK:
+                    printf("New car added to available-for-rent list.\n");
+                    break;
+                case RENTAL_DUPLICATE_PLATE:
+                    printf("Error: Duplicate plate number.\n");
+                    break;
+                default:
+                    printf("Error: The car could not be added.\n");
+                    break;
             }
             break;
 
@@ -105,24 +123,20 @@ int main() {
                 continue;
             }
 
-                 // Remove the car from the rented list (if it exists there).
-            struct car *returned_car = remove_car_from_list(&rented_head, plate);
-            if (returned_car != NULL) // Ensure that the returned car's mileage hasn't decreased (error if true).
+                 // Move the car from the rented list to the available list (the mileage must not decrease).
             {
-                if (mileage < returned_car->mileage) {
+                struct rental_outcome outcome = fleet_return_car(&fleet, plate, mileage, false);
+                if (outcome.result == RENTAL_OK) {
+                    printf("Car returned. Profit: $%.2f\n", outcome.profit);
+                    if (outcome.service_due) {
+                        printf("Warning: Car %s is due for service.\n", outcome.plate);
+                    }
+                } else if (outcome.result == RENTAL_MILEAGE_DECREASED) {
                     printf("Error: Mileage cannot be less than before. Please re-enter the Mileage\n");
                 } else {
-                    // Calculate the profit based on the difference in mileage.
-                    double profit = profit_calculator(returned_car->mileage, mileage);
-                    printf("Car returned. Profit: $%.2f\n", profit);
-                    
-                    // Add the car back to the available list and free its memory.
-                    insert_to_list(&available_head, plate, mileage, -1);
-                    free(returned_car); // Free the memory for the removed car.
+                    // If the car wasn't found in the rented list, show an error.
+                    printf("Error: Car cannot be found in rented list.\n");
                 }
-            } else {
-                // If the car wasn't found in the rented list, show an error.
-                printf("Error: Car cannot be found in rented list.\n");
             }
             break;
 
@@ -146,24 +160,20 @@ int main() {
                 continue;
             }
 
-                // Remove the car from the rented list and validate mileage.
-            struct car *repair_car = remove_car_from_list(&rented_head, plate);
-            if (repair_car != NULL) {
-                // Ensure that the mileage hasn't decreased (error if true).
-                if (mileage < repair_car->mileage) {
+                // Move the car from the rented list to the repair list (the mileage must not decrease).
+            {
+                struct rental_outcome outcome = fleet_return_car(&fleet, plate, mileage, true);
+                if (outcome.result == RENTAL_OK) {
+                    printf("Car returned and sent to repair. Profit: $%.2f\n", outcome.profit);
+                    if (outcome.service_due) {
+                        printf("Warning: Car %s is due for service.\n", outcome.plate);
+                    }
+                } else if (outcome.result == RENTAL_MILEAGE_DECREASED) {
                     printf("Error: Mileage cannot be less than before.\n");
                 } else {
-                    // Calculate the rental profit based on mileage.
-                    double profit = profit_calculator(repair_car->mileage, mileage);
-                    printf("Car returned and sent to repair. Profit: $%.2f\n", profit);
-                    
-                    // Insert the car into the repair list and free its memory.
-                    insert_to_list(&repair_head, plate, mileage, -1);
-                    free(repair_car); // Free the memory for the removed car.
+                    // If the car wasn't found in the rented list, show an error message.
+                    printf("Error: Car not found in rented list.\n");
                 }
-            } else {
-                // If the car wasn't found in the rented list, show an error message.
-                printf("Error: Car not found in rented list.\n");
             }
             break;
 
@@ -180,13 +190,9 @@ int main() {
             }
             to_lowercase(plate);  // Convert the plate number to lowercase for consistent handling
 
-                // Remove the car from the repair list.
-            struct car *transfer_car = remove_car_from_list(&repair_head, plate);
-            if (transfer_car != NULL) {
-                // Add the car to the available-for-rent list and free its memory.
-                insert_to_list(&available_head, plate, transfer_car->mileage, -1);
+                // Move the car from the repair list to the available list.
+            if (fleet_transfer_car(&fleet, plate) == RENTAL_OK) {
                 printf("Car transferred from repair to available-for-rent list.\n");
-                free(transfer_car); // Free the memory for the removed car.
             } else {
                 // If the car wasn't found in the repair list, show an error.
                 printf("Error: Car not found in repair list.\n");
@@ -194,7 +200,7 @@ int main() {
             break;
 
 
-                    // Case 5: Rent the first available car, recording the return date.
+                    // Case 5: Rent the next available car chosen by the allocation policy, recording the return date.
                     case 5:
                         // Loop until a valid return date is entered by the user.
                 while (1) {
@@ -236,42 +242,100 @@ int main() {
                     break;
                 }
 
-                        // Check if there are any available cars to rent.
-                if (available_head == NULL) {
-                    printf("Error: No cars available for rent.\n");
-                } else {
-                    // Rent out the first available car.
-                    struct car *rented_car = remove_first_from_list(&available_head);
-                    insert_to_list(&rented_head, rented_car->plate, rented_car->mileage, return_date);
-                    // Confirm the rental and display the return date.
-                    printf("Car %s rented out. Return Date: ", rented_car->plate);
-                    date(return_date);
-                    printf("\n");
-                    free(rented_car); // Free the removed car's memory.
+                        // Rent out the car chosen by the allocation policy.
+                {
+                    struct rental_outcome outcome = fleet_rent_car(&fleet, return_date);
+                    if (outcome.result == RENTAL_OK) {
+                        // Confirm the rental and display the return date.
+                        printf("Car %s rented out. Return Date: ", outcome.plate);
+                        date(return_date);
+                        printf("\n");
+                    } else {
+                        printf("Error: No cars available for rent.\n");
+                    }
                 }
                 break;
 
             // Case 6: Print the details of all three car lists.
             case 6:
                 printf("\nAvailable-for-Rent List:\n");
-                print_list(available_head);  // Print the available car list.
+                print_list(fleet.available);  // Print the available car list.
                 printf("\nRented List:\n");
-                print_list(rented_head);  // Print the rented car list.
+                print_list(fleet.rented);  // Print the rented car list.
                 printf("\nRepair List:\n");
-                print_list(repair_head);  // Print the repair car list.
+                print_list(fleet.repair);  // Print the repair car list.
                 break;
 
-            // Case 7: Save the car lists to their respective files and quit the program.
+            // Case 7: Rank the available cars by maintenance score so staff know which ones to pull for service.
             case 7:
+                printf("\nCars due for service: %d available, %d rented, %d already in repair.\n",
+                       count_cars_due(fleet.available), count_cars_due(fleet.rented), count_cars_due(fleet.repair));
+                printf("Available cars ranked by maintenance score:\n");
+                print_service_ranking(fleet.available, 10);
+                break;
+
+            // Case 8: Save a snapshot of all three lists on a background thread.
+            case 8:
+                // Never make the menu wait for a snapshot that is still being written.
+                if (snapshot_busy(&fleet.snapshot)) {
+                    printf("The last snapshot is still being saved. Please try again later.\n");
+                    break;
+                }
+                // Report on the previous snapshot before starting a new one (it has finished, so this does not block).
+                if (!snapshot_wait(&fleet.snapshot)) {
+                    printf("Warning: The last background snapshot could not be saved.\n");
+                }
+                if (snapshot_start(&fleet.snapshot, fleet.available, fleet.rented, fleet.repair,
+                                   "available.txt", "rented.txt", "repair.txt")) {
+                    printf("Snapshot started in the background.\n");
+                } else {
+                    printf("Error: Could not start the snapshot.\n");
+                }
+                break;
+
+            // Case 9: Measure how much memory a large fleet uses, compared with the original list nodes.
+            case 9:
+                print_memory_report(MEMORY_REPORT_CARS);
+                break;
+
+            // Case 10: Search all three lists for plates matching part of a plate.
+            case 10:
+                printf("Enter part of a plate number: ");
+                if (scanf("%8s", plate) != 1) { // Read up to 8 characters.
+                    printf("Invalid plate input!\n");
+                    while (getchar() != '\n'); // Clear input buffer.
+                    continue;
+                }
+
+                // Show the plates that start with, contain, or are one typo away from the input.
+                {
+                    const char *titles[3] = {"Plates starting with", "Plates containing", "Plates one character away from"};
+                    for (int mode = 0; mode < 3; mode++) {
+                        int found = mode == 0 ? plate_index_prefix(&fleet.index, plate, matches, 10)
+                                  : mode == 1 ? plate_index_substring(&fleet.index, plate, matches, 10)
+                                  : plate_index_fuzzy(&fleet.index, plate, matches, 10);
+                        printf("%s '%s':%s\n", titles[mode], plate, found == 0 ? " none" : "");
+                        for (int i = 0; i < found; i++) {
+                            printf("  Plate: %s (%s)\n", matches[i].plate, status_names[matches[i].status]);
+                        }
+                    }
+                }
+                break;
+
+            // Case 11: Save the car lists to their respective files and quit the program.
+            case 11:
+                // Let a background snapshot finish first so it cannot overwrite the final save.
+                if (!snapshot_wait(&fleet.snapshot)) {
+                    printf("Warning: The last background snapshot could not be saved.\n");
+                }
                 // Save the current state of all three lists to text files.
-                write_list_to_file("available.txt", available_head);
-                write_list_to_file("rented.txt", rented_head);
-                write_list_to_file("repair.txt", repair_head);
-                printf("Data saved successfully. Exiting...\n");
+                if (fleet_save(&fleet, "available.txt", "rented.txt", "repair.txt")) {
+                    printf("Data saved successfully. Exiting...\n");
+                } else {
+                    printf("Error: Data could not be saved. Exiting...\n");
+                }
                 // Free all memory allocated for the car lists to avoid memory leaks.
-                free_list(&available_head);
-                free_list(&rented_head);
-                free_list(&repair_head);
+                fleet_free(&fleet);
                 return 0; // Exit the program.
 
             // Default case: Handle invalid menu choices.
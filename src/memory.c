@@ -0,0 +1,196 @@
+#define _POSIX_C_SOURCE 200809L // fork() and pipe() for the memory report
+#include "q1.h"
+#include <unistd.h>
+#include <sys/wait.h>
+
+/*
+ * Memory report.
+ * Builds a large fleet the way the program stores it (a malloc'd 'struct car' per car, the plate
+ * index and the allocator's heap) and the list of original nodes it started from, and measures the
+ * resident memory each one adds. The current layout holds more per car than the original one, so
+ * the report shows what the extra features cost rather than a saving.
+ */
+
+// The list node before service history, snapshot versions and back-links were added, for comparison
+struct original_car {
+    char plate[9];
+    int mileage;
+    int return_date;
+    struct original_car *next;
+};
+
+// The layouts the memory report measures
+enum memory_layout {
+    LAYOUT_ORIGINAL_NODES,
+    LAYOUT_FLEET
+};
+
+// The parts of the fleet the memory report measures separately
+enum memory_part {
+    PART_NODES,
+    PART_INDEX,
+    PART_HEAP,
+    PART_COUNT
+};
+
+/*
+ * Reads the resident memory of this process from /proc/self/status.
+ *
+ * @return: Returns the resident memory in kB, or -1 if it cannot be read.
+ */
+static long resident_kb(void) {
+    FILE *file = fopen("/proc/self/status", "r");
+    if (file == NULL) return -1;
+
+    char line[128];
+    long kb = -1;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (sscanf(line, "VmRSS: %ld kB", &kb) == 1) break;
+    }
+    fclose(file);
+    return kb;
+}
+
+/*
+ * Builds 'cars' cars in one layout, filling every field the fleet would, and measures the
+ * resident memory each part added. The original nodes only have the PART_NODES part.
+ * Nothing is freed; the caller runs this in a child process.
+ *
+ * @param layout: The layout to build.
+ * @param cars: The number of cars.
+ * @param kb: Receives the added resident memory of each part in kB.
+ * @return: Returns true if every part was built and measured, false if memory ran out or it cannot be read.
+ */
+static bool build_layout(enum memory_layout layout, long cars, long kb[PART_COUNT]) {
+    long before = resident_kb();
+    if (before < 0) return false;
+    for (int i = 0; i < PART_COUNT; i++) {
+        kb[i] = 0;
+    }
+
+    struct car *head = NULL;
+    struct original_car *original_head = NULL;
+    for (long i = 0; i < cars; i++) {
+        char plate[9];
+        sprintf(plate, "%06lx", (unsigned long)i * 2654435761u & 0xFFFFFFu); // Distinct plates for up to 16M cars
+
+        if (layout == LAYOUT_FLEET) {
+            struct car *car = malloc(sizeof(struct car));
+            if (car == NULL) return false;
+            strcpy(car->plate, plate);
+            car->mileage = (int)(i % 100000);
+            car->return_date = -1;
+            car->rentals = (int)(i % SERVICE_RENTAL_LIMIT);
+            car->service_mileage = car->mileage;
+            car->snapshot_version = 0;
+            car->last_rented = i;
+            car->prev = NULL;
+            car->next = head;
+            if (head != NULL) head->prev = car;
+            head = car;
+        } else {
+            struct original_car *car = malloc(sizeof(struct original_car));
+            if (car == NULL) return false;
+            strcpy(car->plate, plate);
+            car->mileage = (int)(i % 100000);
+            car->return_date = -1;
+            car->next = original_head;
+            original_head = car;
+        }
+    }
+    long after = resident_kb();
+    if (after < 0) return false;
+    kb[PART_NODES] = after - before;
+    if (layout != LAYOUT_FLEET) return true;
+
+    // Index every plate, as fleet_load() and fleet_add_car() do
+    struct plate_index index;
+    if (!plate_index_init(&index)) return false;
+    for (struct car *current = head; current != NULL; current = current->next) {
+        if (!plate_index_set(&index, current->plate, STATUS_AVAILABLE)) return false;
+    }
+    before = after;
+    after = resident_kb();
+    if (after < 0) return false;
+    kb[PART_INDEX] = after - before;
+
+    // Every car is available, so a round-robin or least-recent allocator holds one heap entry per car
+    struct allocator alloc;
+    if (!allocator_init(&alloc, POLICY_LEAST_RECENT, head)) return false;
+    before = after;
+    after = resident_kb();
+    if (after < 0) return false;
+    kb[PART_HEAP] = after - before;
+    return true;
+}
+
+/*
+ * Measures one layout in a child process, so every layout starts from the same heap
+ * and none of the memory stays with the menu afterwards.
+ *
+ * @param layout: The layout to build.
+ * @param cars: The number of cars.
+ * @param kb: Receives the added resident memory of each part in kB.
+ * @return: Returns true if the layout was measured, false otherwise.
+ */
+static bool measure_layout(enum memory_layout layout, long cars, long kb[PART_COUNT]) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+
+    fflush(stdout); // Do not let the child print the parent's buffered output again
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        long child_kb[PART_COUNT];
+        bool ok = build_layout(layout, cars, child_kb);
+        ssize_t written = ok ? write(fds[1], child_kb, sizeof(child_kb)) : 0;
+        _exit(written == (ssize_t)sizeof(child_kb) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t bytes = (ssize_t)(PART_COUNT * sizeof(long));
+    bool ok = read(fds[0], kb, bytes) == bytes; // Nothing is read if the child ran out of memory or failed
+    close(fds[0]);
+    waitpid(pid, NULL, 0);
+    return ok;
+}
+
+// Prints one line of the memory report
+static void print_report_line(const char *label, long cars, long kb) {
+    printf("%-24s %10.1f MB (%.1f bytes per car)\n", label, kb * 1024.0 / 1e6, kb * 1024.0 / cars);
+}
+
+/*
+ * Prints the memory a fleet of the given size uses as the program stores it, part by part,
+ * next to the original list nodes. Each layout is built in its own child process and measured
+ * as the growth in resident memory. The original node does not hold the service history,
+ * snapshot version, last rental or back-link, so it is a baseline rather than an equivalent.
+ *
+ * @param cars: The number of cars to build.
+ */
+void print_memory_report(long cars) {
+    long original[PART_COUNT];
+    long fleet[PART_COUNT];
+
+    printf("\nMeasuring %ld cars in each layout...\n", cars);
+    if (!measure_layout(LAYOUT_ORIGINAL_NODES, cars, original) || !measure_layout(LAYOUT_FLEET, cars, fleet)) {
+        printf("Error: The memory report is not available (out of memory, or /proc/self/status cannot be read).\n");
+        return;
+    }
+
+    print_report_line("Original list nodes:", cars, original[PART_NODES]);
+    printf("  one malloc'd %lu-byte node per car, without history, versions or back-links\n",
+           (unsigned long)sizeof(struct original_car));
+    print_report_line("Current fleet:", cars, fleet[PART_NODES] + fleet[PART_INDEX] + fleet[PART_HEAP]);
+    print_report_line("  List nodes:", cars, fleet[PART_NODES]);
+    printf("    one malloc'd %lu-byte node per car\n", (unsigned long)sizeof(struct car));
+    print_report_line("  Plate index:", cars, fleet[PART_INDEX]);
+    print_report_line("  Allocator heap:", cars, fleet[PART_HEAP]);
+    printf("    %lu-byte entries, only kept by the round-robin and least-recent policies\n",
+           (unsigned long)sizeof(struct allocation_entry));
+}
@@ -1,21 +1,39 @@
+#ifndef Q1_H
+#define Q1_H
+
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
 
 // Our Linked List Node structure
 // This structure represents each car in the system. Each car has:
 // - a 'plate' for the car's license plate
 // - 'mileage' representing the car's current mileage
 // - 'return_date' which is either a valid date (YYMMDD) or -1 for cars with no set return date
-// - 'next' to link to the next car in the list (for the linked list structure)
+// - 'rentals' and 'service_mileage' which record the car's history since its last service
+// - 'snapshot_version' which records the last background snapshot that kept a copy of the car
+// - 'last_rented' which records when the car was last rented out (used by the allocation policies)
+// - 'next' and 'prev' to link to the neighbouring cars in the list (so a known car can be unlinked in O(1))
 struct car {
     char plate[9];          // License plate (maximum 8 characters + null terminator)
     int mileage;            // Current mileage of the car
     int return_date;        // Return date should be -1 for a car with no return date
+    int rentals;            // Number of completed rentals since the car was last serviced
+    int service_mileage;    // Mileage of the car when it was last serviced
+    unsigned snapshot_version; // Version of the snapshot that last copied the car (see snapshot_preserve())
+    long last_rented;       // Allocator clock value when the car was last rented out (0 if never)
     struct car *next;       // Pointer to the next car in the list
+    struct car *prev;       // Pointer to the previous car in the list (NULL for the head)
 };
 
+// Maintenance thresholds: a car is due for service once it has driven
+// SERVICE_INTERVAL_MILES or completed SERVICE_RENTAL_LIMIT rentals since its last service.
+#define SERVICE_INTERVAL_MILES 10000
+#define SERVICE_RENTAL_LIMIT 20
+
 // Function Prototypes
 
 // Displays the primary user interface menu
@@ -67,6 +85,13 @@ void sort_list(struct car **head, bool sort_by_mileage, bool sort_by_return_date
 // Returns: A pointer to the removed car (if found), or NULL if the car is not found in the list.
 struct car *remove_car_from_list(struct car **head, char plate[]);
 
+// Unlinks a car that is known to be on the list, using its 'prev' link.
+// Parameters:
+// - head: A pointer to the pointer of the first node of the linked list.
+// - car: The car to unlink (it is not freed).
+// This takes constant time, unlike remove_car_from_list() which searches by plate.
+void unlink_car(struct car **head, struct car *car);
+
 // Removes the first car from the list (typically used to rent out the first available car).
 // Parameters:
 // - head: A pointer to the pointer of the first node of the linked list.
@@ -85,7 +110,14 @@ double profit_calculator(int initial_mileage, int final_mileage);
 // - filename: The name of the file to write the list to.
 // - head: A pointer to the first node of the linked list.
 // This function writes the plate, mileage, and return date of each car in the list to the specified file.
-void write_list_to_file(char *filename, struct car *head);
+// Returns: 'true' if the file was written, 'false' if it could not be opened or written.
+bool write_list_to_file(char *filename, struct car *head);
+
+// Writes one car as a line of a list file.
+// Parameters:
+// - file: The open file.
+// - car: The car to write (only its saved fields are used).
+void write_car_to_file(FILE *file, const struct car *car);
 
 // Reads car details from a file and adds them to the list (loads the list from a file).
 // Parameters:
@@ -120,3 +152,414 @@ void to_lowercase(char *str);
 
 // Validates if a plate number is between 2 and 8 characters and contains only letters or digits.
 bool is_valid_plate(const char *plate);
+
+// Copies a plate into the form stored on the lists (lowercase, at most the 6 characters kept by insert_to_list()).
+// Parameters:
+// - dest: Receives the normalized plate.
+// - plate: The plate as entered.
+void normalize_plate(char dest[9], const char *plate);
+
+// Calculates how close a car is to needing service.
+// Parameters:
+// - car: The car to score.
+// Returns: The larger of the mileage and rental ratios since the last service (1.0 or more means service is due).
+double maintenance_score(const struct car *car);
+
+// Records a completed rental for a returned car and checks it against the service thresholds.
+// Parameters:
+// - car: The returned car (already carrying its previous history).
+// Returns: 'true' if the car is now due for service.
+// This function only looks at the one car, so it costs the same no matter how large the fleet is.
+bool record_return(struct car *car);
+
+// Counts the cars in the list that are due for service.
+// Parameters:
+// - head: A pointer to the first node of the linked list.
+// Returns: The number of cars with a maintenance score of 1.0 or more.
+int count_cars_due(struct car *head);
+
+// Prints the cars in the list ranked by maintenance score, highest first.
+// Parameters:
+// - head: A pointer to the first node of the linked list.
+// - limit: The maximum number of cars to print.
+void print_service_ranking(struct car *head, int limit);
+
+// Allocation policies used to choose which available car is rented out next.
+enum allocation_policy {
+    POLICY_MILEAGE,         // Lowest mileage first (the head of the sorted available list)
+    POLICY_ROUND_ROBIN,     // The car that has been waiting on the available list the longest
+    POLICY_LEAST_RECENT     // The car that was rented out the longest time ago
+};
+
+// One entry in the allocator's min-heap: the car and the keys it is ordered by.
+struct allocation_entry {
+    struct car *car;        // The available car
+    long key;               // Primary key (arrival order or last rental, depending on the policy)
+    long seq;               // Arrival order on the available list, used to break ties
+};
+
+// Index over the available list for the chosen policy.
+// The mileage policy uses the sorted list itself; the other policies keep a binary min-heap
+// so that choosing a car stays O(log n) as the fleet grows.
+struct allocator {
+    enum allocation_policy policy;
+    struct allocation_entry *heap;  // Min-heap of available cars (unused by the mileage policy)
+    int size;                       // Number of entries in the heap
+    int capacity;                   // Allocated size of the heap
+    long clock;                     // Increases on every add and rental to order events
+};
+
+// Converts a policy name given on the command line into a policy.
+// Parameters:
+// - name: "mileage", "round-robin" or "least-recent".
+// - policy: Receives the parsed policy.
+// Returns: 'true' if the name is known, 'false' otherwise.
+bool parse_allocation_policy(const char *name, enum allocation_policy *policy);
+
+// Sets up an allocator and indexes every car already on the available list.
+// Parameters:
+// - alloc: The allocator to initialize.
+// - policy: The policy used to choose cars.
+// - available_head: A pointer to the first node of the available list.
+// Returns: 'true' on success, 'false' if memory could not be allocated (the allocator is left empty).
+bool allocator_init(struct allocator *alloc, enum allocation_policy policy, struct car *available_head);
+
+// Adds a car that was just inserted into the available list to the allocator's index.
+// Parameters:
+// - alloc: The allocator.
+// - car: The new node on the available list (ignored if NULL).
+// Returns: 'true' on success, 'false' if memory could not be allocated.
+bool allocator_add(struct allocator *alloc, struct car *car);
+
+// Chooses a car according to the policy and removes it from the allocator's index.
+// Parameters:
+// - alloc: The allocator.
+// - available_head: A pointer to the first node of the available list.
+// Returns: The chosen car, or NULL if no car is available. The car is still on the available list;
+// the caller unlinks it with unlink_car(), which takes constant time.
+struct car *allocator_pick(struct allocator *alloc, struct car *available_head);
+
+// Records that a car was rented out by stamping it with the next clock value.
+// Parameters:
+// - alloc: The allocator.
+// - car: The car taken off the available list.
+void allocator_rented(struct allocator *alloc, struct car *car);
+
+// Moves the clock past the last rental saved for the cars of a loaded list, so the
+// least-recently-rented order carries over between runs.
+// Parameters:
+// - alloc: The allocator.
+// - head: A pointer to the first node of the list.
+void allocator_restore_clock(struct allocator *alloc, struct car *head);
+
+// Frees the memory used by the allocator's index (the cars themselves are not freed).
+// Parameters:
+// - alloc: The allocator.
+void allocator_free(struct allocator *alloc);
+
+// Number of hash buckets for the car copies kept while a snapshot is being written.
+#define SNAPSHOT_BUCKETS 1024
+#define SNAPSHOT_NAME_LENGTH 256 // Longest file name a snapshot can write to, including the terminator
+
+// The state a car had when a snapshot started, kept the first time the car is changed afterwards.
+struct snapshot_copy {
+    struct car *car;                // The live car
+    struct car saved;               // Its fields when the snapshot started
+    struct snapshot_copy *next;     // Next copy in the same hash bucket
+};
+
+// Background writer that saves the three lists on a separate thread.
+// Starting a snapshot records only the list heads; cars are copied when they are changed (see snapshot_preserve()).
+struct snapshot_writer {
+    pthread_t thread;               // Thread writing the current snapshot
+    pthread_mutex_t lock;           // Guards 'done', 'lost_copy', 'copies' and the cars' 'snapshot_version'
+    bool running;                   // 'true' while a snapshot has been started and not yet waited for
+    bool done;                      // 'true' once the thread has written every list
+    bool ok;                        // 'true' if the last snapshot was written successfully
+    bool lost_copy;                 // 'true' if a copy could not be allocated, so the snapshot is abandoned
+    unsigned version;               // Version of the current snapshot; cars stamped with it have a copy
+    struct car *heads[3];           // Available, rented and repair list heads when the snapshot started
+    char files[3][SNAPSHOT_NAME_LENGTH]; // Files the three lists are saved to
+    struct snapshot_copy *copies[SNAPSHOT_BUCKETS]; // Copies of the cars changed since then
+};
+
+// Prepares a snapshot writer (no thread is started).
+// Parameters:
+// - writer: The writer to initialize.
+void snapshot_init(struct snapshot_writer *writer);
+
+// Keeps a copy of a car before it is changed, if a running snapshot still needs its old state.
+// Parameters:
+// - writer: The snapshot writer.
+// - car: The car about to be changed.
+// Call this before changing a car's plate, mileage, return date, rentals, service mileage or 'next' link.
+void snapshot_preserve(struct snapshot_writer *writer, struct car *car);
+
+// Checks whether a snapshot is still being written.
+// Parameters:
+// - writer: The snapshot writer.
+// Returns: 'true' while the thread is still writing, 'false' otherwise.
+bool snapshot_busy(struct snapshot_writer *writer);
+
+// Starts a thread that saves the three lists, as they are now, to the three given files.
+// Parameters:
+// - writer: The snapshot writer.
+// - available_head, rented_head, repair_head: The first nodes of the three lists.
+// - available_file, rented_file, repair_file: The files to save the lists to (copied, so they need not outlive the call).
+// Returns: 'true' if the snapshot was started, 'false' if a snapshot is still being written, a file name is
+// SNAPSHOT_NAME_LENGTH characters or longer, or the thread failed to start.
+// This takes constant time; the lists can be changed as soon as it returns, through the fleet_* functions.
+bool snapshot_start(struct snapshot_writer *writer, struct car *available_head, struct car *rented_head, struct car *repair_head,
+                    char *available_file, char *rented_file, char *repair_file);
+
+// Waits for the running snapshot (if any) to finish and frees the copies kept for it.
+// Parameters:
+// - writer: The snapshot writer.
+// Returns: 'true' if there was no snapshot or it was saved successfully, 'false' if it could not be saved.
+bool snapshot_wait(struct snapshot_writer *writer);
+
+// Waits for the running snapshot (if any) and releases the writer.
+// Parameters:
+// - writer: The snapshot writer.
+void snapshot_free(struct snapshot_writer *writer);
+
+// Which list a car is on.
+enum car_status {
+    STATUS_AVAILABLE,
+    STATUS_RENTED,
+    STATUS_REPAIR
+};
+
+// Number of cars print_memory_report() measures each layout with.
+#define MEMORY_REPORT_CARS 10000000
+
+// Builds the given number of cars as the fleet stores them (list nodes, plate index and allocator heap)
+// and as the original list nodes, one layout at a time, and prints the resident memory each part added.
+// Parameters:
+// - cars: The number of cars to build.
+void print_memory_report(long cars);
+
+#define PLATE_NOT_FOUND -1   // Status of a plate that is not on any list
+
+#define PLATE_ALPHABET 36            // Letters and digits that can appear in a normalized plate
+#define PLATE_PAIRS (PLATE_ALPHABET * PLATE_ALPHABET) // Pairs of adjacent characters
+#define PLATE_ENTRY_CHUNK 4096       // Number of plate entries allocated at a time
+
+// A plate known to the search index (8 bytes).
+struct plate_entry {
+    char plate[7];          // Normalized plate (at most 6 characters, see normalize_plate())
+    int8_t status;          // enum car_status, or PLATE_NOT_FOUND once the car has been removed
+};
+
+// Posting list for one pair of adjacent characters: every plate that contains the pair.
+// Each posting is the plate's entry number shifted left by 3, plus the position of the pair in the plate.
+struct plate_postings {
+    uint32_t *items;        // Postings in the order the plates were added
+    uint32_t count;         // Number of postings
+    uint32_t capacity;      // Allocated postings (grows by half, so at most a third is unused)
+};
+
+// Open-addressing hash table from a plate to its entry.
+struct plate_table {
+    uint32_t *slots;        // Entry number + 1 for each slot, 0 when empty
+    uint32_t size;          // Number of slots (a power of two, or 0)
+};
+
+// Index over every plate on the three lists, used for exact, prefix, substring and one-typo searches.
+// Entries are never deleted; a removed plate keeps its entry with status PLATE_NOT_FOUND.
+// When the hash table grows, the old table is kept and its plates are moved a few at a time by the
+// following inserts, so no single insert has to rehash every plate.
+struct plate_index {
+    struct plate_entry **entries;   // Chunks of PLATE_ENTRY_CHUNK entries
+    uint32_t entry_count;           // Number of entries in use
+    uint32_t chunk_count;           // Number of allocated chunks
+    struct plate_table table;       // Finds a plate's entry
+    struct plate_table old_table;   // The table before it last grew, until all of its plates are moved
+    uint32_t moved;                 // Number of slots of 'old_table' already moved
+    struct plate_postings pairs[PLATE_PAIRS]; // Posting list for each pair of adjacent characters
+};
+
+// A plate returned by a search.
+struct plate_match {
+    char plate[9];          // The matching plate
+    enum car_status status; // The list the car is on
+};
+
+// The three lists, the allocator and the plate index that together make up the rental engine.
+// Use the fleet_* functions below to change it so that every check and index stays in step.
+struct fleet {
+    struct car *available;  // Cars available for rent, sorted by mileage
+    struct car *rented;     // Rented cars, sorted by return date
+    struct car *repair;     // Cars under repair, sorted by mileage
+    struct allocator alloc; // Chooses which available car is rented next
+    struct plate_index index; // Plate search index over all three lists
+    struct snapshot_writer snapshot; // Saves the lists in the background
+};
+
+// Result of a fleet command.
+enum rental_result {
+    RENTAL_OK,                  // The command was applied
+    RENTAL_INVALID_PLATE,       // The plate is not 2-8 letters or digits
+    RENTAL_DUPLICATE_PLATE,     // A car with this plate is already on one of the lists
+    RENTAL_NOT_FOUND,           // The car is not on the list the command takes it from
+    RENTAL_MILEAGE_DECREASED,   // The new mileage is lower than the recorded mileage
+    RENTAL_INVALID_DATE,        // The return date is not a valid YYMMDD date
+    RENTAL_NO_CARS,             // No cars are available for rent
+    RENTAL_NO_MEMORY            // Memory could not be allocated
+};
+
+// Detailed outcome of a return or a rental.
+struct rental_outcome {
+    enum rental_result result;  // Whether the command was applied
+    char plate[9];              // Plate of the car returned or rented (empty on failure)
+    int mileage;                // Mileage of the car after the command
+    double profit;              // Profit from a returned rental (0 for rentals)
+    bool service_due;           // 'true' if a returned car crossed a service threshold
+};
+
+// One return in a batch (see fleet_return_batch()).
+struct return_request {
+    char plate[9];              // Plate of the rented car
+    int mileage;                // Mileage when the car came back
+    bool to_repair;             // 'true' to send the car to the repair list instead of the available list
+};
+
+// Sets up an empty fleet.
+// Parameters:
+// - fleet: The fleet to initialize.
+// - policy: The allocation policy used when renting cars.
+// Returns: 'true' on success, 'false' if memory could not be allocated.
+bool fleet_init(struct fleet *fleet, enum allocation_policy policy);
+
+// Loads the three lists from files and indexes the cars.
+// Parameters:
+// - fleet: The fleet (its lists should be empty).
+// - available_file, rented_file, repair_file: The files to read (missing files are skipped).
+// Returns: 'true' on success, 'false' if the allocator or the plate index ran out of memory.
+// After a failed load the fleet must only be freed: some of the loaded cars are not indexed.
+bool fleet_load(struct fleet *fleet, char *available_file, char *rented_file, char *repair_file);
+
+// Saves the three lists to files.
+// Parameters:
+// - fleet: The fleet.
+// - available_file, rented_file, repair_file: The files to write.
+// Returns: 'true' if every file was written, 'false' otherwise.
+bool fleet_save(struct fleet *fleet, char *available_file, char *rented_file, char *repair_file);
+
+// Frees every car in the fleet and both indexes.
+// Parameters:
+// - fleet: The fleet.
+void fleet_free(struct fleet *fleet);
+
+// Adds a new car to the available list.
+// Parameters:
+// - fleet: The fleet.
+// - plate: The plate of the new car (2-8 letters or digits, any case).
+// - mileage: The car's mileage.
+// Returns: RENTAL_OK, RENTAL_INVALID_PLATE, RENTAL_DUPLICATE_PLATE or RENTAL_NO_MEMORY.
+enum rental_result fleet_add_car(struct fleet *fleet, const char *plate, int mileage);
+
+// Returns a rented car to the available list, or to the repair list.
+// Parameters:
+// - fleet: The fleet.
+// - plate: The plate of the rented car.
+// - mileage: The car's mileage when it came back (must not be lower than before).
+// - to_repair: 'true' to send the car to the repair list.
+// Returns: The outcome, with the profit and whether the car is due for service.
+// The car stays on the rented list if the command fails.
+struct rental_outcome fleet_return_car(struct fleet *fleet, const char *plate, int mileage, bool to_repair);
+
+// Moves a car from the repair list back to the available list (this resets its service history).
+// Parameters:
+// - fleet: The fleet.
+// - plate: The plate of the car under repair.
+// Returns: RENTAL_OK, RENTAL_NOT_FOUND or RENTAL_NO_MEMORY.
+enum rental_result fleet_transfer_car(struct fleet *fleet, const char *plate);
+
+// Rents out the available car chosen by the allocation policy.
+// Parameters:
+// - fleet: The fleet.
+// - return_date: The return date in YYMMDD format.
+// Returns: The outcome, with the plate and mileage of the rented car.
+struct rental_outcome fleet_rent_car(struct fleet *fleet, int return_date);
+
+// Applies many returns in one pass.
+// Parameters:
+// - fleet: The fleet.
+// - requests: The returns to apply, in order.
+// - count: The number of requests.
+// - outcomes: Receives one outcome per request.
+// Returns: The number of returns that were applied.
+int fleet_return_batch(struct fleet *fleet, const struct return_request *requests, int count, struct rental_outcome *outcomes);
+
+// Applies many rentals in one pass.
+// Parameters:
+// - fleet: The fleet.
+// - return_dates: The return date (YYMMDD) of each rental, in order.
+// - count: The number of rentals.
+// - outcomes: Receives one outcome per rental.
+// Returns: The number of rentals that were applied.
+int fleet_rent_batch(struct fleet *fleet, const int *return_dates, int count, struct rental_outcome *outcomes);
+
+// Applies many transfers from the repair list in one pass.
+// Parameters:
+// - fleet: The fleet.
+// - plates: The plates of the cars to transfer, in order.
+// - count: The number of transfers.
+// - results: Receives one result per transfer.
+// Returns: The number of transfers that were applied.
+int fleet_transfer_batch(struct fleet *fleet, char plates[][9], int count, enum rental_result *results);
+
+// Prepares an empty plate index.
+// Parameters:
+// - index: The index to initialize.
+// Returns: 'true' on success, 'false' if memory could not be allocated.
+bool plate_index_init(struct plate_index *index);
+
+// Adds a plate to the index, or updates its status if it is already there.
+// Parameters:
+// - index: The plate index.
+// - plate: The plate (any case).
+// - status: The list the car is now on.
+// Returns: 'true' on success, 'false' if memory could not be allocated (the index is unchanged).
+// Updating the status of a plate that is already indexed never allocates, so it cannot fail.
+bool plate_index_set(struct plate_index *index, const char *plate, enum car_status status);
+
+// Marks a plate as no longer on any list.
+// Parameters:
+// - index: The plate index.
+// - plate: The plate (any case).
+void plate_index_remove(struct plate_index *index, const char *plate);
+
+// Looks up the status of a plate.
+// Parameters:
+// - index: The plate index.
+// - plate: The plate (any case).
+// Returns: The list the car is on (enum car_status), or PLATE_NOT_FOUND.
+int plate_index_status(struct plate_index *index, const char *plate);
+
+// Finds the plates that start with the query.
+// Parameters:
+// - index: The plate index.
+// - query: The start of the plate (any case).
+// - matches: Receives the matching plates.
+// - max_matches: The size of the 'matches' array.
+// Returns: The number of matches stored.
+int plate_index_prefix(struct plate_index *index, const char *query, struct plate_match *matches, int max_matches);
+
+// Finds the plates that contain the query anywhere.
+// Parameters: the same as plate_index_prefix().
+// Returns: The number of matches stored.
+int plate_index_substring(struct plate_index *index, const char *query, struct plate_match *matches, int max_matches);
+
+// Finds the plates that differ from the query by at most one character (one wrong, missing or extra character).
+// Parameters: the same as plate_index_prefix().
+// Returns: The number of matches stored.
+int plate_index_fuzzy(struct plate_index *index, const char *query, struct plate_match *matches, int max_matches);
+
+// Frees the memory used by the plate index.
+// Parameters:
+// - index: The plate index.
+void plate_index_free(struct plate_index *index);
+
+#endif // Q1_H
@@ -47,6 +47,18 @@ void to_lowercase(char *str) {
     }
 }
 
+/*
+ * Copies a plate into the form stored on the lists: lowercase and cut to the length kept by insert_to_list().
+ *
+ * @param dest: Receives the normalized plate.
+ * @param plate: The plate as entered.
+ */
+void normalize_plate(char dest[9], const char *plate) {
+    strncpy(dest, plate, 6);
+    dest[6] = '\0';
+    to_lowercase(dest);
+}
+
 /*
  * Checks if a given date in the format YYMMDD is valid.
  * This function checks the validity of the day and month extracted from the date.
@@ -84,9 +96,13 @@ void prompt() {
     printf("2. Add a returned car to the available-for-rent list,\n");
     printf("3. Add a returned car to the repair list,\n");
     printf("4. Transfer a car from the repair list to the available for rent list,\n");
-    printf("5. Rent the first available car,\n");
+    printf("5. Rent the next available car,\n");
     printf("6. Print all the lists,\n");
-    printf("7. Quit.\n");
+    printf("7. Rank available cars for service,\n");
+    printf("8. Save a snapshot in the background,\n");
+    printf("9. Show the memory report,\n");
+    printf("10. Search for a plate,\n");
+    printf("11. Quit.\n");
     printf("Enter your chosen option please: ");
 }
 
@@ -114,11 +130,17 @@ struct car *insert_to_list(struct car **head, char plate[], int mileage, int ret
     // Initialize car's attributes: 
     new_car->mileage = mileage;
     new_car->return_date = return_date;
+    new_car->rentals = 0;               // A new car starts with a clean service history
+    new_car->service_mileage = mileage;
+    new_car->snapshot_version = 0;      // No snapshot has copied the car yet
+    new_car->last_rented = 0;
     new_car->next = NULL;
+    new_car->prev = NULL;
     // If the list is empty or the new car should be inserted at the head
     if (*head == NULL || (return_date == -1 && (*head)->mileage > mileage) || 
         (return_date != -1 && (*head)->return_date > return_date)) {
         new_car->next = *head;
+        if (*head != NULL) (*head)->prev = new_car;
         *head = new_car;
         return new_car;
     }
@@ -131,6 +153,8 @@ struct car *insert_to_list(struct car **head, char plate[], int mileage, int ret
     }
     // Insert the new car node in the correct position
     new_car->next = current->next;
+    new_car->prev = current;
+    if (current->next != NULL) current->next->prev = new_car;
     current->next = new_car;
 
     return new_car;
@@ -198,6 +222,11 @@ void swap(struct car *a, struct car *b) {
     struct car temp = *a; // Temporary storage for swapping
     *a = *b;
     *b = temp;
+    // Keep each node's position in the list; only the details move
+    b->next = a->next;
+    b->prev = a->prev;
+    a->next = temp.next;
+    a->prev = temp.prev;
 }
 
 /*
@@ -239,7 +268,6 @@ struct car *remove_car_from_list(struct car **head, char plate[]) {
     to_lowercase(lower_plate);       // Convert the input plate to lowercase
 
     struct car *current = *head;
-    struct car *previous = NULL;
     
     // Traverse the list to search for the plate number
     while (current != NULL) {
@@ -251,14 +279,9 @@ struct car *remove_car_from_list(struct car **head, char plate[]) {
         // Match found, remove the car from the list
         if (strcmp(lower_plate, stored_plate) == 0) {
             // Match found, remove the car from the list
-            if (previous == NULL) {
-                *head = current->next; // If the car is at the head
-            } else {
-                previous->next = current->next; // Remove the car from the middle or end
-            }
+            unlink_car(head, current); // Remove the car from the head, middle or end
             return current; // Return the removed car node
         }
-        previous = current;
         current = current->next;
     }
     return NULL;  // Car with the given plate not found
@@ -276,10 +299,28 @@ struct car *remove_first_from_list(struct car **head) {
     if (*head == NULL) return NULL; // List is empty
 
     struct car *temp = *head;
-    *head = (*head)->next; // Update head to the next car in the list
+    unlink_car(head, temp); // Update head to the next car in the list
     return temp;
 }
 
+/*
+ * Unlinks a car from the list it is on.
+ * The 'prev' link gives the car's neighbour directly, so no search is needed.
+ *
+ * @param head: Pointer to the pointer of the list's head.
+ * @param car: The car to unlink.
+ */
+void unlink_car(struct car **head, struct car *car) {
+    if (car->prev != NULL) {
+        car->prev->next = car->next;
+    } else {
+        *head = car->next; // The car is the head
+    }
+    if (car->next != NULL) car->next->prev = car->prev;
+    car->next = NULL;
+    car->prev = NULL;
+}
+
 /*
  * Calculates the profit made by renting a car based on mileage difference.
  * The profit formula is $80 for up to 200 miles, and an additional $0.15 for every extra mile.
@@ -299,29 +340,43 @@ double profit_calculator(int initial_mileage, int final_mileage) {
 
 /*
  * Writes the details of all cars in the list to a file.
- * Each car's details (plate, mileage, and return date) are written to the file in CSV format.
+ * Each car's details (plate, mileage, return date, rentals and service mileage) are written to the file in CSV format.
  *
  * @param filename: The name of the file to write to.
  * @param head: Pointer to the head of the linked list.
+ * @return: Returns true if the file was written, false otherwise.
  */
-void write_list_to_file(char *filename, struct car *head) {
+bool write_list_to_file(char *filename, struct car *head) {
     FILE *file = fopen(filename, "w");
-    if (file == NULL) return; // File opening failed
+    if (file == NULL) return false; // File opening failed
 
     struct car *current = head;
     
     // Write each car's details to the file in CSV format
     while (current != NULL) {
-        fprintf(file, "%s,%d,%d\n", current->plate, current->mileage, current->return_date);
+        write_car_to_file(file, current);
         current = current->next;
     }
 
-    fclose(file); // Close the file
+    bool ok = !ferror(file);       // Check that every write succeeded
+    return fclose(file) == 0 && ok; // Close the file
+}
+
+/*
+ * Writes one car's details (plate, mileage, return date, rentals, service mileage and last rental) as a CSV line.
+ *
+ * @param file: The open file.
+ * @param car: The car to write.
+ */
+void write_car_to_file(FILE *file, const struct car *car) {
+    fprintf(file, "%s,%d,%d,%d,%d,%ld\n", car->plate, car->mileage, car->return_date,
+            car->rentals, car->service_mileage, car->last_rented);
 }
 
 /*
  * Reads car details from a file and adds them to the list.
  * The function reads each car's details from the file (in CSV format) and inserts them into the list.
+ * Files saved before maintenance tracking existed only have three fields; those cars start with a clean history.
  *
  * @param filename: The name of the file to read from.
  * @param head: Pointer to the pointer of the list's head.
@@ -330,13 +385,26 @@ void read_file_into_list(char *filename, struct car **head) {
     FILE *file = fopen(filename, "r");
     if (file == NULL) return; // File opening failed
 
+    char line[128];
     char plate[7];
     int mileage;
     int return_date;
-    
+    int rentals;
+    int service_mileage;
+    long last_rented;
+
     // Read each car's details from the file and insert into the list
-    while (fscanf(file, "%6[^,],%d,%d\n", plate, &mileage, &return_date) == 3) {
-        insert_to_list(head, plate, mileage, return_date);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        int fields = sscanf(line, "%6[^,],%d,%d,%d,%d,%ld", plate, &mileage, &return_date, &rentals, &service_mileage,
+                            &last_rented);
+        if (fields < 3) break; // Stop at the first malformed line
+
+        struct car *new_car = insert_to_list(head, plate, mileage, return_date);
+        if (new_car != NULL && fields >= 5) {
+            new_car->rentals = rentals;
+            new_car->service_mileage = service_mileage;
+        }
+        if (new_car != NULL && fields == 6) new_car->last_rented = last_rented;
     }
 
     fclose(file); // Close the file
@@ -373,3 +441,85 @@ void free_list(struct car **head) {
 
     *head = NULL; // Set the head to NULL after freeing all nodes
 }
+
+/*
+ * Calculates a car's maintenance score.
+ * The score is the larger of two ratios: miles driven since the last service over SERVICE_INTERVAL_MILES,
+ * and rentals since the last service over SERVICE_RENTAL_LIMIT. A score of 1.0 or more means service is due.
+ *
+ * @param car: The car to score.
+ * @return: Returns the maintenance score.
+ */
+double maintenance_score(const struct car *car) {
+    double mileage_ratio = (double)(car->mileage - car->service_mileage) / SERVICE_INTERVAL_MILES;
+    double rental_ratio = (double)car->rentals / SERVICE_RENTAL_LIMIT;
+    return mileage_ratio > rental_ratio ? mileage_ratio : rental_ratio;
+}
+
+/*
+ * Records a completed rental for a returned car.
+ * Only the returned car is scored, so this check runs on every return without walking the lists.
+ *
+ * @param car: The returned car.
+ * @return: Returns true if the car is now due for service.
+ */
+bool record_return(struct car *car) {
+    if (car == NULL) return false;
+    car->rentals++;
+    return maintenance_score(car) >= 1.0;
+}
+
+/*
+ * Counts the cars in a list that are due for service.
+ *
+ * @param head: Pointer to the head of the linked list.
+ * @return: Returns the number of cars with a maintenance score of 1.0 or more.
+ */
+int count_cars_due(struct car *head) {
+    int count = 0;
+    for (struct car *current = head; current != NULL; current = current->next) {
+        if (maintenance_score(current) >= 1.0) count++;
+    }
+    return count;
+}
+
+// Helper for qsort: orders cars by maintenance score, highest first
+static int compare_by_score(const void *a, const void *b) {
+    double score_a = maintenance_score(*(struct car *const *)a);
+    double score_b = maintenance_score(*(struct car *const *)b);
+    return (score_a < score_b) - (score_a > score_b);
+}
+
+/*
+ * Prints the cars in a list ranked by maintenance score, highest first.
+ * Cars that are due for service are marked so staff know which ones to pull first.
+ *
+ * @param head: Pointer to the head of the linked list.
+ * @param limit: The maximum number of cars to print.
+ */
+void print_service_ranking(struct car *head, int limit) {
+    int count = 0;
+    for (struct car *current = head; current != NULL; current = current->next) count++;
+    if (count == 0) {
+        printf("No cars in the list.\n");
+        return;
+    }
+
+    struct car **cars = malloc(count * sizeof(struct car *));
+    if (cars == NULL) { // Handle memory allocation failure
+        printf("Error: Not enough memory to rank the cars.\n");
+        return;
+    }
+
+    int i = 0;
+    for (struct car *current = head; current != NULL; current = current->next) cars[i++] = current;
+    qsort(cars, count, sizeof(struct car *), compare_by_score);
+
+    // Print the highest scoring cars
+    for (i = 0; i < count && i < limit; i++) {
+        double score = maintenance_score(cars[i]);
+        printf("Plate: %s, Mileage: %d, Rentals: %d, Score: %.2f%s\n", cars[i]->plate, cars[i]->mileage,
+               cars[i]->rentals, score, score >= 1.0 ? " (service due)" : "");
+    }
+    free(cars);
+}
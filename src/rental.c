@@ -0,0 +1,592 @@
+#include "q1.h"
+
+/*
+ * Command API for the rental engine.
+ * These functions hold the transaction rules (duplicate checks, mileage validation, profit,
+ * moving cars between lists) so that the menu in main.c, embedding programs and benchmarks
+ * all go through the same code. Nothing here reads input or prints.
+ */
+
+/*
+ * Finds the car with the given (normalized) plate on a list.
+ * The car can then be unlinked with take_car() without a second pass over the list.
+ *
+ * @param head: Pointer to the list's head.
+ * @param plate: The normalized plate.
+ * @return: Returns the car, or NULL if it is not on the list.
+ */
+static struct car *find_car(struct car *head, const char *plate) {
+    for (struct car *current = head; current != NULL; current = current->next) {
+        if (strcmp(current->plate, plate) == 0) return current;
+    }
+    return NULL;
+}
+
+/*
+ * Unlinks a car so it can be changed and moved to another list.
+ * The car and the car before it are kept for a running snapshot first, since both are about to change.
+ *
+ * @param fleet: The fleet.
+ * @param head: Pointer to the pointer of the list's head.
+ * @param car: The car to unlink.
+ */
+static void take_car(struct fleet *fleet, struct car **head, struct car *car) {
+    snapshot_preserve(&fleet->snapshot, car);
+    if (car->prev != NULL) snapshot_preserve(&fleet->snapshot, car->prev);
+    unlink_car(head, car);
+}
+
+/*
+ * Links an existing car into a list, in the same order insert_to_list() uses:
+ * by mileage for cars with no return date, otherwise by return date.
+ * Moving the node itself means moving a car between lists never allocates memory.
+ *
+ * @param fleet: The fleet.
+ * @param head: Pointer to the pointer of the destination list's head.
+ * @param car: The car to link (already taken off its previous list, or new).
+ */
+static void link_sorted(struct fleet *fleet, struct car **head, struct car *car) {
+    struct car *previous = NULL;
+    struct car *current = *head;
+    while (current != NULL && ((car->return_date == -1 && current->mileage < car->mileage) ||
+                               (car->return_date != -1 && current->return_date < car->return_date))) {
+        previous = current;
+        current = current->next;
+    }
+    car->prev = previous;
+    car->next = current;
+    if (current != NULL) current->prev = car;
+    if (previous == NULL) {
+        *head = car;
+    } else {
+        snapshot_preserve(&fleet->snapshot, previous);
+        previous->next = car;
+    }
+}
+
+/*
+ * Sets up an empty fleet.
+ *
+ * @param fleet: The fleet to initialize.
+ * @param policy: The allocation policy used when renting cars.
+ * @return: Returns true on success, false if memory could not be allocated.
+ */
+bool fleet_init(struct fleet *fleet, enum allocation_policy policy) {
+    fleet->available = NULL;
+    fleet->rented = NULL;
+    fleet->repair = NULL;
+    allocator_init(&fleet->alloc, policy, NULL); // An empty list needs no memory, so this cannot fail
+    snapshot_init(&fleet->snapshot);
+    return plate_index_init(&fleet->index);
+}
+
+// Adds every car on a list to the plate index
+static bool index_list(struct fleet *fleet, struct car *head, enum car_status status) {
+    for (struct car *current = head; current != NULL; current = current->next) {
+        if (!plate_index_set(&fleet->index, current->plate, status)) return false;
+    }
+    return true;
+}
+
+/*
+ * Loads the three lists from files and rebuilds the allocator's index.
+ *
+ * @param fleet: The fleet.
+ * @param available_file: File with the available cars.
+ * @param rented_file: File with the rented cars.
+ * @param repair_file: File with the cars under repair.
+ * @return: Returns true on success, false if the allocator or the plate index ran out of memory.
+ */
+bool fleet_load(struct fleet *fleet, char *available_file, char *rented_file, char *repair_file) {
+    read_file_into_list(available_file, &fleet->available);
+    read_file_into_list(rented_file, &fleet->rented);
+    read_file_into_list(repair_file, &fleet->repair);
+
+    enum allocation_policy policy = fleet->alloc.policy;
+    allocator_free(&fleet->alloc);
+    if (!allocator_init(&fleet->alloc, policy, fleet->available)) return false; // Index the loaded cars
+    allocator_restore_clock(&fleet->alloc, fleet->available);
+    allocator_restore_clock(&fleet->alloc, fleet->rented);
+    allocator_restore_clock(&fleet->alloc, fleet->repair);
+
+    return index_list(fleet, fleet->available, STATUS_AVAILABLE) && index_list(fleet, fleet->rented, STATUS_RENTED) &&
+           index_list(fleet, fleet->repair, STATUS_REPAIR);
+}
+
+/*
+ * Saves the three lists to files.
+ *
+ * @param fleet: The fleet.
+ * @param available_file: File for the available cars.
+ * @param rented_file: File for the rented cars.
+ * @param repair_file: File for the cars under repair.
+ * @return: Returns true if every file was written.
+ */
+bool fleet_save(struct fleet *fleet, char *available_file, char *rented_file, char *repair_file) {
+    bool ok = write_list_to_file(available_file, fleet->available);
+    ok = write_list_to_file(rented_file, fleet->rented) && ok;
+    ok = write_list_to_file(repair_file, fleet->repair) && ok;
+    return ok;
+}
+
+/*
+ * Frees every car in the fleet, the allocator's index and the plate index.
+ * A snapshot that is still being written is waited for first, since it reads the cars.
+ *
+ * @param fleet: The fleet.
+ */
+void fleet_free(struct fleet *fleet) {
+    snapshot_free(&fleet->snapshot);
+    free_list(&fleet->available);
+    free_list(&fleet->rented);
+    free_list(&fleet->repair);
+    allocator_free(&fleet->alloc);
+    plate_index_free(&fleet->index);
+}
+
+/*
+ * Adds a new car to the available list after checking its plate.
+ *
+ * @param fleet: The fleet.
+ * @param plate: The plate of the new car.
+ * @param mileage: The car's mileage.
+ * @return: Returns RENTAL_OK or the reason the car was not added.
+ */
+enum rental_result fleet_add_car(struct fleet *fleet, const char *plate, int mileage) {
+    if (!is_valid_plate(plate)) return RENTAL_INVALID_PLATE;
+
+    char key[9];
+    normalize_plate(key, plate);
+
+    // The plate index covers every car on every list, so a plate is never on two lists at once
+    if (plate_index_status(&fleet->index, key) != PLATE_NOT_FOUND) return RENTAL_DUPLICATE_PLATE;
+    if (!plate_index_set(&fleet->index, key, STATUS_AVAILABLE)) return RENTAL_NO_MEMORY;
+
+    // Allocate memory for a new car node
+    struct car *new_car = (struct car *)malloc(sizeof(struct car));
+    if (new_car == NULL) {
+        plate_index_remove(&fleet->index, key);
+        return RENTAL_NO_MEMORY;
+    }
+    strcpy(new_car->plate, key);
+    new_car->mileage = mileage;
+    new_car->return_date = -1;
+    new_car->rentals = 0;               // A new car starts with a clean service history
+    new_car->service_mileage = mileage;
+    new_car->snapshot_version = fleet->snapshot.version; // A running snapshot cannot reach the new car
+    new_car->last_rented = 0;
+    link_sorted(fleet, &fleet->available, new_car);
+
+    if (!allocator_add(&fleet->alloc, new_car)) {
+        take_car(fleet, &fleet->available, new_car); // Do not keep a car the allocator cannot choose
+        free(new_car);
+        plate_index_remove(&fleet->index, key);
+        return RENTAL_NO_MEMORY;
+    }
+    return RENTAL_OK;
+}
+
+/*
+ * Returns a rented car to the available list or the repair list.
+ * Everything that can fail is checked before the car is unlinked, so a failed return leaves it rented.
+ *
+ * @param fleet: The fleet.
+ * @param plate: The plate of the rented car.
+ * @param mileage: The car's mileage when it came back.
+ * @param to_repair: True to send the car to the repair list.
+ * @return: Returns the outcome of the return.
+ */
+struct rental_outcome fleet_return_car(struct fleet *fleet, const char *plate, int mileage, bool to_repair) {
+    struct rental_outcome outcome = {RENTAL_OK, "", 0, 0.0, false};
+    char key[9];
+    normalize_plate(key, plate);
+
+    struct car *car = find_car(fleet->rented, key);
+    if (car == NULL) {
+        outcome.result = RENTAL_NOT_FOUND;
+        return outcome;
+    }
+    if (mileage < car->mileage) {
+        outcome.result = RENTAL_MILEAGE_DECREASED;
+        return outcome;
+    }
+    if (!to_repair && !allocator_add(&fleet->alloc, car)) {
+        outcome.result = RENTAL_NO_MEMORY;
+        return outcome;
+    }
+
+    // Move the car to its new list
+    take_car(fleet, &fleet->rented, car);
+    outcome.profit = profit_calculator(car->mileage, mileage);
+    car->mileage = mileage;
+    car->return_date = -1;
+    outcome.service_due = record_return(car);
+    link_sorted(fleet, to_repair ? &fleet->repair : &fleet->available, car);
+    // Every car on a list is indexed (a failed fleet_load() leaves the fleet only fit to free),
+    // so this only changes the plate's status and cannot fail
+    plate_index_set(&fleet->index, key, to_repair ? STATUS_REPAIR : STATUS_AVAILABLE);
+
+    strcpy(outcome.plate, car->plate);
+    outcome.mileage = mileage;
+    return outcome;
+}
+
+/*
+ * Moves a car from the repair list to the available list.
+ * The car was serviced while under repair, so its service history starts again.
+ *
+ * @param fleet: The fleet.
+ * @param plate: The plate of the car under repair.
+ * @return: Returns RENTAL_OK or the reason the car was not moved.
+ */
+enum rental_result fleet_transfer_car(struct fleet *fleet, const char *plate) {
+    char key[9];
+    normalize_plate(key, plate);
+
+    struct car *car = find_car(fleet->repair, key);
+    if (car == NULL) return RENTAL_NOT_FOUND;
+    if (!allocator_add(&fleet->alloc, car)) return RENTAL_NO_MEMORY;
+
+    take_car(fleet, &fleet->repair, car); // Unlink the car from the repair list
+    car->rentals = 0;
+    car->service_mileage = car->mileage;
+    link_sorted(fleet, &fleet->available, car);
+    plate_index_set(&fleet->index, key, STATUS_AVAILABLE);
+    return RENTAL_OK;
+}
+
+/*
+ * Rents out the available car chosen by the allocation policy.
+ *
+ * @param fleet: The fleet.
+ * @param return_date: The return date in YYMMDD format.
+ * @return: Returns the outcome of the rental.
+ */
+struct rental_outcome fleet_rent_car(struct fleet *fleet, int return_date) {
+    struct rental_outcome outcome = {RENTAL_OK, "", 0, 0.0, false};
+
+    if (!is_valid_date(return_date)) {
+        outcome.result = RENTAL_INVALID_DATE;
+        return outcome;
+    }
+
+    struct car *car = allocator_pick(&fleet->alloc, fleet->available);
+    if (car == NULL) {
+        outcome.result = RENTAL_NO_CARS;
+        return outcome;
+    }
+    take_car(fleet, &fleet->available, car); // Constant time, whichever car the policy chose
+    allocator_rented(&fleet->alloc, car);
+    car->return_date = return_date;
+    link_sorted(fleet, &fleet->rented, car);
+    plate_index_set(&fleet->index, car->plate, STATUS_RENTED);
+
+    strcpy(outcome.plate, car->plate);
+    outcome.mileage = car->mileage;
+    return outcome;
+}
+
+// One command in a batch, or one car moved by it
+struct batch_entry {
+    char plate[9];      // Normalized plate of the request
+    int request;        // Position of the request in the batch
+    struct car *car;    // The car the request applies to, or NULL
+};
+
+// Orders batch entries by plate, and requests for the same plate in batch order
+static int compare_by_plate(const void *a, const void *b) {
+    const struct batch_entry *entry_a = a;
+    const struct batch_entry *entry_b = b;
+    int order = strcmp(entry_a->plate, entry_b->plate);
+    return order != 0 ? order : entry_a->request - entry_b->request;
+}
+
+// Orders batch entries back into batch order
+static int compare_by_request(const void *a, const void *b) {
+    return ((const struct batch_entry *)a)->request - ((const struct batch_entry *)b)->request;
+}
+
+// Returns the key a list is sorted by: the mileage for cars with no return date, otherwise the return date
+static int list_key(const struct car *car) {
+    return car->return_date == -1 ? car->mileage : car->return_date;
+}
+
+// Orders moved cars by list key; for equal keys the car moved last comes first, as with link_sorted()
+static int compare_by_key(const void *a, const void *b) {
+    const struct batch_entry *entry_a = a;
+    const struct batch_entry *entry_b = b;
+    int key_a = list_key(entry_a->car);
+    int key_b = list_key(entry_b->car);
+    if (key_a != key_b) return key_a < key_b ? -1 : 1;
+    return entry_b->request - entry_a->request;
+}
+
+/*
+ * Finds the cars a batch applies to with one walk over a list.
+ * The entries must be sorted by plate; each car is looked up by binary search and stored
+ * in the first entry for its plate, so this takes O(n log k) for n cars and k entries.
+ *
+ * @param head: Pointer to the head of the list.
+ * @param entries: The batch entries, sorted with compare_by_plate().
+ * @param count: The number of entries.
+ */
+static void find_batch_cars(struct car *head, struct batch_entry *entries, int count) {
+    for (int i = 0; i < count; i++) entries[i].car = NULL;
+
+    for (struct car *current = head; current != NULL; current = current->next) {
+        // Find the first entry whose plate is not less than the car's
+        int low = 0;
+        int high = count;
+        while (low < high) {
+            int middle = low + (high - low) / 2;
+            if (strcmp(entries[middle].plate, current->plate) < 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (low < count && strcmp(entries[low].plate, current->plate) == 0) entries[low].car = current;
+    }
+}
+
+/*
+ * Links moved cars into a list with one walk over it, in the order link_sorted() would give.
+ *
+ * @param fleet: The fleet.
+ * @param head: Pointer to the pointer of the destination list's head.
+ * @param moved: The cars to link (already taken off their previous list).
+ * @param count: The number of cars.
+ */
+static void merge_sorted(struct fleet *fleet, struct car **head, struct batch_entry *moved, int count) {
+    qsort(moved, count, sizeof(struct batch_entry), compare_by_key);
+
+    struct car *previous = NULL;
+    struct car *current = *head;
+    for (int i = 0; i < count; i++) {
+        struct car *car = moved[i].car;
+        while (current != NULL && list_key(current) < list_key(car)) {
+            previous = current;
+            current = current->next;
+        }
+        car->prev = previous;
+        car->next = current;
+        if (current != NULL) current->prev = car;
+        if (previous == NULL) {
+            *head = car;
+        } else {
+            snapshot_preserve(&fleet->snapshot, previous);
+            previous->next = car;
+        }
+        previous = car; // The next car goes after this one
+    }
+}
+
+/*
+ * Applies many returns with one walk over the rented list and one over each destination list.
+ * The requests are sorted by plate to find their cars, checked in batch order, and the returned
+ * cars are merged into the available and repair lists. The outcomes are the same as applying
+ * the requests one at a time with fleet_return_car().
+ *
+ * @param fleet: The fleet.
+ * @param requests: The returns to apply.
+ * @param count: The number of requests.
+ * @param outcomes: Receives one outcome per request.
+ * @return: Returns the number of returns that were applied.
+ */
+int fleet_return_batch(struct fleet *fleet, const struct return_request *requests, int count, struct rental_outcome *outcomes) {
+    int applied = 0;
+    if (count <= 0) return 0;
+
+    struct batch_entry *entries = malloc(count * sizeof(struct batch_entry));
+    struct batch_entry *moved = malloc(count * sizeof(struct batch_entry));
+    if (entries == NULL || moved == NULL) {
+        // Without room for the batch, apply the returns one at a time
+        free(entries);
+        free(moved);
+        for (int i = 0; i < count; i++) {
+            outcomes[i] = fleet_return_car(fleet, requests[i].plate, requests[i].mileage, requests[i].to_repair);
+            if (outcomes[i].result == RENTAL_OK) applied++;
+        }
+        return applied;
+    }
+
+    for (int i = 0; i < count; i++) {
+        normalize_plate(entries[i].plate, requests[i].plate);
+        entries[i].request = i;
+    }
+    qsort(entries, count, sizeof(struct batch_entry), compare_by_plate);
+    find_batch_cars(fleet->rented, entries, count);
+
+    // The first request for a plate with a valid mileage gets the car; later ones find it already returned
+    for (int start = 0, end; start < count; start = end) {
+        struct car *car = entries[start].car;
+        for (end = start; end < count && strcmp(entries[end].plate, entries[start].plate) == 0; end++) {
+            struct rental_outcome *outcome = &outcomes[entries[end].request];
+            *outcome = (struct rental_outcome){RENTAL_NOT_FOUND, "", 0, 0.0, false};
+            entries[end].car = NULL;
+            if (car != NULL && requests[entries[end].request].mileage < car->mileage) {
+                outcome->result = RENTAL_MILEAGE_DECREASED;
+            } else if (car != NULL) {
+                entries[end].car = car;
+                car = NULL;
+            }
+        }
+    }
+
+    // Apply the returns in batch order, so the allocator sees the cars in the same order as single returns
+    qsort(entries, count, sizeof(struct batch_entry), compare_by_request);
+    int to_available = 0;
+    int to_repair = count; // Cars for the repair list fill 'moved' from the end
+    for (int i = 0; i < count; i++) {
+        struct car *car = entries[i].car;
+        if (car == NULL) continue;
+        const struct return_request *request = &requests[i];
+        if (!request->to_repair && !allocator_add(&fleet->alloc, car)) {
+            outcomes[i].result = RENTAL_NO_MEMORY;
+            continue;
+        }
+
+        take_car(fleet, &fleet->rented, car);
+        outcomes[i].result = RENTAL_OK;
+        outcomes[i].profit = profit_calculator(car->mileage, request->mileage);
+        car->mileage = request->mileage;
+        car->return_date = -1;
+        outcomes[i].service_due = record_return(car);
+        plate_index_set(&fleet->index, car->plate, request->to_repair ? STATUS_REPAIR : STATUS_AVAILABLE);
+        strcpy(outcomes[i].plate, car->plate);
+        outcomes[i].mileage = car->mileage;
+
+        struct batch_entry *slot = request->to_repair ? &moved[--to_repair] : &moved[to_available++];
+        slot->car = car;
+        slot->request = i;
+        applied++;
+    }
+    merge_sorted(fleet, &fleet->available, moved, to_available);
+    merge_sorted(fleet, &fleet->repair, moved + to_repair, count - to_repair);
+
+    free(entries);
+    free(moved);
+    return applied;
+}
+
+/*
+ * Applies many rentals, then merges the rented cars into the rented list with one walk over it.
+ * The outcomes are the same as renting the cars one at a time with fleet_rent_car().
+ *
+ * @param fleet: The fleet.
+ * @param return_dates: The return date of each rental.
+ * @param count: The number of rentals.
+ * @param outcomes: Receives one outcome per rental.
+ * @return: Returns the number of rentals that were applied.
+ */
+int fleet_rent_batch(struct fleet *fleet, const int *return_dates, int count, struct rental_outcome *outcomes) {
+    int applied = 0;
+    if (count <= 0) return 0;
+
+    struct batch_entry *moved = malloc(count * sizeof(struct batch_entry));
+    if (moved == NULL) {
+        // Without room for the batch, apply the rentals one at a time
+        for (int i = 0; i < count; i++) {
+            outcomes[i] = fleet_rent_car(fleet, return_dates[i]);
+            if (outcomes[i].result == RENTAL_OK) applied++;
+        }
+        return applied;
+    }
+
+    for (int i = 0; i < count; i++) {
+        outcomes[i] = (struct rental_outcome){RENTAL_OK, "", 0, 0.0, false};
+        if (!is_valid_date(return_dates[i])) {
+            outcomes[i].result = RENTAL_INVALID_DATE;
+            continue;
+        }
+        struct car *car = allocator_pick(&fleet->alloc, fleet->available);
+        if (car == NULL) {
+            outcomes[i].result = RENTAL_NO_CARS;
+            continue;
+        }
+
+        take_car(fleet, &fleet->available, car);
+        allocator_rented(&fleet->alloc, car);
+        car->return_date = return_dates[i];
+        plate_index_set(&fleet->index, car->plate, STATUS_RENTED);
+        strcpy(outcomes[i].plate, car->plate);
+        outcomes[i].mileage = car->mileage;
+
+        moved[applied].car = car;
+        moved[applied].request = i;
+        applied++;
+    }
+    merge_sorted(fleet, &fleet->rented, moved, applied);
+
+    free(moved);
+    return applied;
+}
+
+/*
+ * Applies many transfers from the repair list with one walk over the repair list and one over
+ * the available list, in the same way as fleet_return_batch(). The results are the same as
+ * transferring the cars one at a time with fleet_transfer_car().
+ *
+ * @param fleet: The fleet.
+ * @param plates: The plates of the cars to transfer.
+ * @param count: The number of transfers.
+ * @param results: Receives one result per transfer.
+ * @return: Returns the number of transfers that were applied.
+ */
+int fleet_transfer_batch(struct fleet *fleet, char plates[][9], int count, enum rental_result *results) {
+    int applied = 0;
+    if (count <= 0) return 0;
+
+    struct batch_entry *entries = malloc(count * sizeof(struct batch_entry));
+    struct batch_entry *moved = malloc(count * sizeof(struct batch_entry));
+    if (entries == NULL || moved == NULL) {
+        // Without room for the batch, apply the transfers one at a time
+        free(entries);
+        free(moved);
+        for (int i = 0; i < count; i++) {
+            results[i] = fleet_transfer_car(fleet, plates[i]);
+            if (results[i] == RENTAL_OK) applied++;
+        }
+        return applied;
+    }
+
+    for (int i = 0; i < count; i++) {
+        normalize_plate(entries[i].plate, plates[i]);
+        entries[i].request = i;
+    }
+    qsort(entries, count, sizeof(struct batch_entry), compare_by_plate);
+    find_batch_cars(fleet->repair, entries, count);
+
+    // Only the first request for a plate gets the car; later ones find it already transferred
+    for (int start = 0, end; start < count; start = end) {
+        for (end = start + 1; end < count && strcmp(entries[end].plate, entries[start].plate) == 0; end++) {
+            entries[end].car = NULL;
+        }
+    }
+
+    qsort(entries, count, sizeof(struct batch_entry), compare_by_request);
+    for (int i = 0; i < count; i++) {
+        struct car *car = entries[i].car;
+        results[i] = RENTAL_NOT_FOUND;
+        if (car == NULL) continue;
+        if (!allocator_add(&fleet->alloc, car)) {
+            results[i] = RENTAL_NO_MEMORY;
+            continue;
+        }
+
+        take_car(fleet, &fleet->repair, car);
+        car->rentals = 0; // The car was serviced while under repair
+        car->service_mileage = car->mileage;
+        plate_index_set(&fleet->index, car->plate, STATUS_AVAILABLE);
+        results[i] = RENTAL_OK;
+
+        moved[applied].car = car;
+        moved[applied].request = i;
+        applied++;
+    }
+    merge_sorted(fleet, &fleet->available, moved, applied);
+
+    free(entries);
+    free(moved);
+    return applied;
+}
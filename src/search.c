@@ -0,0 +1,430 @@
+#include "q1.h"
+
+/*
+ * Plate search index.
+ * Each plate is stored once as an 8-byte entry. A hash table finds the entry for an exact plate,
+ * and one posting list per pair of adjacent characters records which plates contain the pair and
+ * where. A prefix or substring search scans the shortest posting list among the query's pairs and
+ * checks each plate on it; a one-typo search looks up every plate one edit away from the query in
+ * the hash table. A plate of n characters costs its entry, n - 1 postings of 4 bytes and its hash
+ * slots, and every array grows in small steps so no insert copies the whole index.
+ */
+
+#define PLATE_TABLE_MIN_SIZE 1024   // Size of the first hash table
+#define PLATE_MOVES_PER_INSERT 8    // Old hash table slots moved by each insert while the table grows
+
+// Returns the position of a character in the plate alphabet, or -1 if it is not a lowercase letter or digit
+static int char_code(char ch) {
+    if (ch >= 'a' && ch <= 'z') return ch - 'a';
+    if (ch >= '0' && ch <= '9') return 26 + (ch - '0');
+    return -1;
+}
+
+// Returns the posting list number for the pair of characters starting at 'pair', or -1 for other characters
+static int pair_code(const char *pair) {
+    int first = char_code(pair[0]);
+    int second = char_code(pair[1]);
+    if (first == -1 || second == -1) return -1;
+    return first * PLATE_ALPHABET + second;
+}
+
+// Returns the entry with the given number
+static struct plate_entry *get_entry(struct plate_index *index, uint32_t entry) {
+    return &index->entries[entry / PLATE_ENTRY_CHUNK][entry % PLATE_ENTRY_CHUNK];
+}
+
+// Hashes a plate (FNV-1a)
+static uint32_t hash_plate(const char *plate) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; plate[i] != '\0'; i++) {
+        hash = (hash ^ (unsigned char)plate[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Returns the slot of a table that holds the plate, or the empty slot where it would go
+static uint32_t table_slot(struct plate_index *index, struct plate_table *table, const char *plate) {
+    uint32_t mask = table->size - 1;
+    uint32_t slot = hash_plate(plate) & mask;
+    while (table->slots[slot] != 0 && strcmp(get_entry(index, table->slots[slot] - 1)->plate, plate) != 0) {
+        slot = (slot + 1) & mask; // Probe the following slots
+    }
+    return slot;
+}
+
+// Finds a normalized plate's entry number, looking in the old table too while it is being moved
+static int find_entry(struct plate_index *index, const char *plate) {
+    if (index->table.size == 0) return PLATE_NOT_FOUND;
+
+    uint32_t slot = table_slot(index, &index->table, plate);
+    if (index->table.slots[slot] != 0) return (int)index->table.slots[slot] - 1;
+
+    if (index->old_table.slots != NULL) {
+        slot = table_slot(index, &index->old_table, plate);
+        if (index->old_table.slots[slot] != 0) return (int)index->old_table.slots[slot] - 1;
+    }
+    return PLATE_NOT_FOUND;
+}
+
+// Moves up to 'count' slots of the old hash table into the new one, and frees it once it is empty
+static void move_old_slots(struct plate_index *index, uint32_t count) {
+    if (index->old_table.slots == NULL) return;
+
+    for (; count > 0 && index->moved < index->old_table.size; count--, index->moved++) {
+        uint32_t entry = index->old_table.slots[index->moved];
+        if (entry == 0) continue;
+        // The old slot is left in place, so lookups in the old table still find the plates after it
+        uint32_t slot = table_slot(index, &index->table, get_entry(index, entry - 1)->plate);
+        index->table.slots[slot] = entry;
+    }
+    if (index->moved == index->old_table.size) {
+        free(index->old_table.slots);
+        index->old_table.slots = NULL;
+        index->old_table.size = 0;
+    }
+}
+
+// Makes sure the hash table can take one more plate, starting a table twice as large once it is half full
+static bool reserve_table_slot(struct plate_index *index) {
+    if ((uint64_t)(index->entry_count + 1) * 2 <= index->table.size) return true;
+
+    // The old table is always moved before the new one fills up; finish it in case it was not
+    move_old_slots(index, index->old_table.size);
+
+    uint32_t size = index->table.size == 0 ? PLATE_TABLE_MIN_SIZE : index->table.size * 2;
+    uint32_t *slots = calloc(size, sizeof(uint32_t)); // Large tables get zeroed pages from the system
+    if (slots == NULL) return false; // Handle memory allocation failure
+
+    index->old_table = index->table;
+    if (index->old_table.size == 0) index->old_table.slots = NULL;
+    index->table.slots = slots;
+    index->table.size = size;
+    index->moved = 0;
+    return true;
+}
+
+// Makes sure a posting list can take 'extra' more postings, growing it by half
+static bool reserve_postings(struct plate_postings *list, uint32_t extra) {
+    if (list->count + extra <= list->capacity) return true;
+
+    uint32_t capacity = list->capacity < 8 ? 8 : list->capacity + list->capacity / 2;
+    if (capacity < list->count + extra) capacity = list->count + extra;
+    uint32_t *items = realloc(list->items, capacity * sizeof(uint32_t));
+    if (items == NULL) return false; // Handle memory allocation failure
+    list->items = items;
+    list->capacity = capacity;
+    return true;
+}
+
+// Makes sure there is room for one more entry, adding a chunk when the last one is full
+static bool reserve_entry(struct plate_index *index) {
+    if (index->entry_count < index->chunk_count * PLATE_ENTRY_CHUNK) return true;
+    if (index->entry_count >= (1u << 29)) return false; // Postings keep the entry number in 29 bits
+
+    struct plate_entry **entries = realloc(index->entries, (index->chunk_count + 1) * sizeof(struct plate_entry *));
+    if (entries == NULL) return false; // Handle memory allocation failure
+    index->entries = entries;
+
+    entries[index->chunk_count] = malloc(PLATE_ENTRY_CHUNK * sizeof(struct plate_entry));
+    if (entries[index->chunk_count] == NULL) return false;
+    index->chunk_count++;
+    return true;
+}
+
+// Normalizes a query and checks it only contains letters and digits
+static bool normalize_query(char dest[9], const char *query) {
+    if (query[0] == '\0') return false;
+    for (int i = 0; query[i] != '\0'; i++) {
+        if (!((query[i] >= '0' && query[i] <= '9') || (query[i] >= 'a' && query[i] <= 'z') ||
+              (query[i] >= 'A' && query[i] <= 'Z'))) {
+            return false;
+        }
+    }
+    normalize_plate(dest, query);
+    return true;
+}
+
+// Stores an entry as a match unless it was removed
+static void add_match(struct plate_index *index, uint32_t entry, struct plate_match *matches, int *count) {
+    struct plate_entry *plate = get_entry(index, entry);
+    if (plate->status == PLATE_NOT_FOUND) return;
+
+    strcpy(matches[*count].plate, plate->plate);
+    matches[*count].status = (enum car_status)plate->status;
+    (*count)++;
+}
+
+/*
+ * Prepares an empty plate index.
+ *
+ * @param index: The index to initialize.
+ * @return: Returns true on success, false if memory could not be allocated.
+ */
+bool plate_index_init(struct plate_index *index) {
+    memset(index, 0, sizeof(*index));
+    if (!reserve_table_slot(index)) {
+        plate_index_free(index);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Adds a plate and its pairs of characters, or updates the status of a plate that is already indexed.
+ * All memory is reserved first, so a failure leaves the index as it was.
+ *
+ * @param index: The plate index.
+ * @param plate: The plate.
+ * @param status: The list the car is now on.
+ * @return: Returns true on success, false if memory could not be allocated.
+ */
+bool plate_index_set(struct plate_index *index, const char *plate, enum car_status status) {
+    char key[9];
+    normalize_plate(key, plate);
+
+    // A plate that is already indexed only needs its status changed
+    int found = find_entry(index, key);
+    if (found != PLATE_NOT_FOUND) {
+        get_entry(index, (uint32_t)found)->status = (int8_t)status;
+        return true;
+    }
+
+    int length = strlen(key);
+    if (!reserve_entry(index) || !reserve_table_slot(index)) return false;
+    for (int i = 0; i + 1 < length; i++) {
+        int pair = pair_code(key + i);
+        if (pair != -1 && !reserve_postings(&index->pairs[pair], (uint32_t)(length - 1))) return false;
+    }
+
+    uint32_t entry = index->entry_count++;
+    strcpy(get_entry(index, entry)->plate, key);
+    get_entry(index, entry)->status = (int8_t)status;
+    index->table.slots[table_slot(index, &index->table, key)] = entry + 1;
+    move_old_slots(index, PLATE_MOVES_PER_INSERT);
+
+    // Record the plate in the posting list of each pair of adjacent characters
+    for (int i = 0; i + 1 < length; i++) {
+        int pair = pair_code(key + i);
+        if (pair != -1) {
+            struct plate_postings *list = &index->pairs[pair];
+            list->items[list->count++] = entry << 3 | (uint32_t)i;
+        }
+    }
+    return true;
+}
+
+/*
+ * Marks a plate as no longer on any list. Its entry stays in the index so it can be added again cheaply.
+ *
+ * @param index: The plate index.
+ * @param plate: The plate.
+ */
+void plate_index_remove(struct plate_index *index, const char *plate) {
+    char key[9];
+    normalize_plate(key, plate);
+
+    int found = find_entry(index, key);
+    if (found != PLATE_NOT_FOUND) get_entry(index, (uint32_t)found)->status = PLATE_NOT_FOUND;
+}
+
+/*
+ * Looks up the status of a plate.
+ *
+ * @param index: The plate index.
+ * @param plate: The plate.
+ * @return: Returns the list the car is on, or PLATE_NOT_FOUND.
+ */
+int plate_index_status(struct plate_index *index, const char *plate) {
+    char key[9];
+    normalize_plate(key, plate);
+
+    int found = find_entry(index, key);
+    if (found == PLATE_NOT_FOUND) return PLATE_NOT_FOUND;
+    return get_entry(index, (uint32_t)found)->status;
+}
+
+/*
+ * Finds the plates that contain a single character (at the start only, if 'prefix' is set).
+ * Every character of a plate is the first or the last of some pair, so the posting lists of the pairs
+ * starting or ending with the character cover every such plate. A plate is only taken from the pair
+ * at the character's first occurrence, so each plate is returned once.
+ *
+ * @param index: The plate index.
+ * @param ch: The character.
+ * @param prefix: True to only find plates that start with the character.
+ * @param matches: Receives the matching plates.
+ * @param max_matches: The size of the matches array.
+ * @return: Returns the number of matches stored.
+ */
+static int find_character(struct plate_index *index, char ch, bool prefix, struct plate_match *matches, int max_matches) {
+    int code = char_code(ch);
+    int count = 0;
+
+    for (int other = 0; other < PLATE_ALPHABET && count < max_matches; other++) {
+        // Pairs starting with the character
+        struct plate_postings *list = &index->pairs[code * PLATE_ALPHABET + other];
+        for (uint32_t i = 0; i < list->count && count < max_matches; i++) {
+            uint32_t position = list->items[i] & 7;
+            struct plate_entry *entry = get_entry(index, list->items[i] >> 3);
+            if (prefix ? position == 0 : strchr(entry->plate, ch) == entry->plate + position) {
+                add_match(index, list->items[i] >> 3, matches, &count);
+            }
+        }
+        if (prefix) continue;
+
+        // Pairs ending with the character, for plates where it only appears as the last character
+        list = &index->pairs[other * PLATE_ALPHABET + code];
+        for (uint32_t i = 0; i < list->count && count < max_matches; i++) {
+            uint32_t position = (list->items[i] & 7) + 1;
+            struct plate_entry *entry = get_entry(index, list->items[i] >> 3);
+            if (entry->plate[position + 1] == '\0' && strchr(entry->plate, ch) == entry->plate + position) {
+                add_match(index, list->items[i] >> 3, matches, &count);
+            }
+        }
+    }
+    return count;
+}
+
+/*
+ * Finds the plates that contain the query (at the start only, if 'prefix' is set).
+ * A query of two or more characters scans the shortest posting list among its pairs and checks the
+ * plate around each posting. A plate is only taken at the first place the query occurs in it, so
+ * each plate is returned once.
+ *
+ * @param index: The plate index.
+ * @param key: The normalized query.
+ * @param prefix: True to only find plates that start with the query.
+ * @param matches: Receives the matching plates.
+ * @param max_matches: The size of the matches array.
+ * @return: Returns the number of matches stored.
+ */
+static int find_text(struct plate_index *index, const char *key, bool prefix, struct plate_match *matches, int max_matches) {
+    int length = strlen(key);
+    if (length == 1) return find_character(index, key[0], prefix, matches, max_matches);
+
+    // Scan the rarest pair; for a prefix search the pair's position in the plate must equal its offset in the query
+    int offset = 0;
+    for (int i = 1; i + 1 < length; i++) {
+        if (index->pairs[pair_code(key + i)].count < index->pairs[pair_code(key + offset)].count) offset = i;
+    }
+
+    int count = 0;
+    struct plate_postings *list = &index->pairs[pair_code(key + offset)];
+    for (uint32_t i = 0; i < list->count && count < max_matches; i++) {
+        int start = (int)(list->items[i] & 7) - offset;
+        if (start < 0 || (prefix && start != 0)) continue;
+
+        struct plate_entry *entry = get_entry(index, list->items[i] >> 3);
+        if ((int)strlen(entry->plate) - start < length || strncmp(entry->plate + start, key, length) != 0) continue;
+        if (strstr(entry->plate, key) == entry->plate + start) add_match(index, list->items[i] >> 3, matches, &count);
+    }
+    return count;
+}
+
+/*
+ * Finds the plates that start with the query.
+ *
+ * @param index: The plate index.
+ * @param query: The start of the plate.
+ * @param matches: Receives the matching plates.
+ * @param max_matches: The size of the matches array.
+ * @return: Returns the number of matches stored.
+ */
+int plate_index_prefix(struct plate_index *index, const char *query, struct plate_match *matches, int max_matches) {
+    char key[9];
+    if (!normalize_query(key, query)) return 0;
+    return find_text(index, key, true, matches, max_matches);
+}
+
+/*
+ * Finds the plates that contain the query anywhere.
+ *
+ * @param index: The plate index.
+ * @param query: Part of the plate.
+ * @param matches: Receives the matching plates.
+ * @param max_matches: The size of the matches array.
+ * @return: Returns the number of matches stored.
+ */
+int plate_index_substring(struct plate_index *index, const char *query, struct plate_match *matches, int max_matches) {
+    char key[9];
+    if (!normalize_query(key, query)) return 0;
+    return find_text(index, key, false, matches, max_matches);
+}
+
+// Looks up one candidate plate for a one-typo search and stores it if it is indexed and not returned yet
+static void add_candidate(struct plate_index *index, const char *candidate, struct plate_match *matches, int *count) {
+    int found = find_entry(index, candidate);
+    if (found == PLATE_NOT_FOUND) return;
+
+    // The same plate can be reached by two edits (e.g. deleting either of two equal characters)
+    for (int i = 0; i < *count; i++) {
+        if (strcmp(matches[i].plate, candidate) == 0) return;
+    }
+    add_match(index, (uint32_t)found, matches, count);
+}
+
+/*
+ * Finds the plates within one edit (a wrong, missing or extra character) of the query.
+ * Every plate one edit away is built and looked up in the hash table: at most a few hundred
+ * lookups for a 6-character query, whatever the size of the fleet.
+ *
+ * @param index: The plate index.
+ * @param query: The plate as the customer remembers it.
+ * @param matches: Receives the matching plates.
+ * @param max_matches: The size of the matches array.
+ * @return: Returns the number of matches stored.
+ */
+int plate_index_fuzzy(struct plate_index *index, const char *query, struct plate_match *matches, int max_matches) {
+    static const char alphabet[PLATE_ALPHABET + 1] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    char key[9];
+    if (!normalize_query(key, query)) return 0;
+
+    int length = strlen(key);
+    int count = 0;
+    char candidate[9];
+    if (count < max_matches) add_candidate(index, key, matches, &count); // The query itself
+
+    for (int i = 0; i < length && count < max_matches; i++) {
+        // A wrong character at position i
+        strcpy(candidate, key);
+        for (int c = 0; c < PLATE_ALPHABET && count < max_matches; c++) {
+            if (alphabet[c] == key[i]) continue;
+            candidate[i] = alphabet[c];
+            add_candidate(index, candidate, matches, &count);
+        }
+
+        // An extra character at position i (the plate is one shorter)
+        memcpy(candidate, key, i);
+        strcpy(candidate + i, key + i + 1);
+        if (length > 1 && count < max_matches) add_candidate(index, candidate, matches, &count);
+    }
+
+    // A character missing from the query (the plate is one longer); stored plates have at most 6 characters
+    for (int i = 0; i <= length && length < 6 && count < max_matches; i++) {
+        memcpy(candidate, key, i);
+        strcpy(candidate + i + 1, key + i);
+        for (int c = 0; c < PLATE_ALPHABET && count < max_matches; c++) {
+            candidate[i] = alphabet[c];
+            add_candidate(index, candidate, matches, &count);
+        }
+    }
+    return count;
+}
+
+/*
+ * Frees the memory used by the plate index.
+ *
+ * @param index: The plate index.
+ */
+void plate_index_free(struct plate_index *index) {
+    for (uint32_t i = 0; i < index->chunk_count; i++) {
+        free(index->entries[i]);
+    }
+    free(index->entries);
+    free(index->table.slots);
+    free(index->old_table.slots);
+    for (int i = 0; i < PLATE_PAIRS; i++) {
+        free(index->pairs[i].items);
+    }
+    memset(index, 0, sizeof(*index));
+}
@@ -0,0 +1,239 @@
+#include "q1.h"
+
+/*
+ * Background snapshots of the three car lists.
+ * Starting a snapshot only records the three list heads and a new version number, so the foreground
+ * cost does not depend on the size of the fleet. The cars are versioned instead of copied up front:
+ * the first time a car is changed while the snapshot is being written, snapshot_preserve() keeps a copy
+ * of its old state and stamps the car with the snapshot's version. The writer thread walks the lists
+ * from the recorded heads and uses the copy for every stamped car, which gives it a consistent
+ * point-in-time view while the menu keeps serving transactions on the live lists.
+ */
+
+/*
+ * Prepares a snapshot writer.
+ *
+ * @param writer: The writer to initialize.
+ */
+void snapshot_init(struct snapshot_writer *writer) {
+    writer->running = false;
+    writer->done = false;
+    writer->ok = true;
+    writer->lost_copy = false;
+    writer->version = 0;
+    pthread_mutex_init(&writer->lock, NULL);
+    for (int i = 0; i < 3; i++) {
+        writer->heads[i] = NULL;
+        writer->files[i][0] = '\0';
+    }
+    for (int i = 0; i < SNAPSHOT_BUCKETS; i++) {
+        writer->copies[i] = NULL;
+    }
+}
+
+// Returns the hash bucket for the copy of a car
+static int copy_bucket(const struct car *car) {
+    return (int)(((uintptr_t)car >> 4) % SNAPSHOT_BUCKETS);
+}
+
+/*
+ * Keeps the current state of a car before it is changed, if a snapshot is being written
+ * and the car has not been copied for it yet. Must be called before changing any field the
+ * snapshot saves (plate, mileage, return date, rentals, service mileage, last rental or the 'next' link).
+ *
+ * @param writer: The snapshot writer.
+ * @param car: The car about to be changed.
+ */
+void snapshot_preserve(struct snapshot_writer *writer, struct car *car) {
+    if (!writer->running || car->snapshot_version == writer->version) return; // Nothing to keep
+
+    pthread_mutex_lock(&writer->lock);
+    if (!writer->done) {
+        struct snapshot_copy *copy = malloc(sizeof(struct snapshot_copy));
+        if (copy == NULL) {
+            writer->lost_copy = true; // The thread gives up rather than save a mix of old and new cars
+        } else {
+            int bucket = copy_bucket(car);
+            copy->car = car;
+            copy->saved = *car;
+            copy->next = writer->copies[bucket];
+            writer->copies[bucket] = copy;
+        }
+        car->snapshot_version = writer->version;
+    }
+    pthread_mutex_unlock(&writer->lock);
+}
+
+/*
+ * Reads the fields a snapshot saves, as they were when the snapshot started.
+ * Called by the writer thread with the lock held.
+ *
+ * @param writer: The snapshot writer.
+ * @param car: The live car.
+ * @param view: Receives the car's saved fields.
+ */
+static void read_car(struct snapshot_writer *writer, struct car *car, struct car *view) {
+    const struct car *source = car;
+    if (car->snapshot_version == writer->version) {
+        // The car changed after the snapshot started; use the copy kept by snapshot_preserve()
+        struct snapshot_copy *copy = writer->copies[copy_bucket(car)];
+        while (copy->car != car) copy = copy->next;
+        source = &copy->saved;
+    }
+    strcpy(view->plate, source->plate);
+    view->mileage = source->mileage;
+    view->return_date = source->return_date;
+    view->rentals = source->rentals;
+    view->service_mileage = source->service_mileage;
+    view->last_rented = source->last_rented;
+    view->next = source->next;
+}
+
+/*
+ * Writes one list of the snapshot to a temporary file,
+ * then renames it over the real file so a crash never leaves a half-written list.
+ *
+ * @param writer: The snapshot writer.
+ * @param list: Which of the three lists to write.
+ * @return: Returns true if the list was saved, false otherwise.
+ */
+static bool write_snapshot_list(struct snapshot_writer *writer, int list) {
+    char temp_name[SNAPSHOT_NAME_LENGTH + 4];
+    sprintf(temp_name, "%s.tmp", writer->files[list]);
+    FILE *file = fopen(temp_name, "w");
+    if (file == NULL) return false; // File opening failed
+
+    bool ok = true;
+    struct car *current = writer->heads[list];
+    while (ok && current != NULL) {
+        struct car view;
+        pthread_mutex_lock(&writer->lock);
+        ok = !writer->lost_copy;
+        if (ok) read_car(writer, current, &view);
+        pthread_mutex_unlock(&writer->lock);
+
+        if (ok) {
+            write_car_to_file(file, &view);
+            current = view.next;
+        }
+    }
+
+    ok = !ferror(file) && ok;   // Check that every write succeeded
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temp_name, writer->files[list]) != 0) {
+        remove(temp_name);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Thread function: writes the three lists of the snapshot.
+ *
+ * @param arg: The snapshot writer.
+ * @return: Always NULL; the result is stored in writer->ok.
+ */
+static void *write_snapshot(void *arg) {
+    struct snapshot_writer *writer = arg;
+    bool ok = true;
+
+    for (int i = 0; i < 3; i++) {
+        ok = write_snapshot_list(writer, i) && ok;
+    }
+
+    writer->ok = ok; // Read by snapshot_wait() after the thread is joined
+    pthread_mutex_lock(&writer->lock);
+    writer->done = true; // Cars no longer need to be copied
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+/*
+ * Checks whether a snapshot is still being written.
+ *
+ * @param writer: The snapshot writer.
+ * @return: Returns true while the thread is writing, false if no snapshot is running or it has finished.
+ */
+bool snapshot_busy(struct snapshot_writer *writer) {
+    if (!writer->running) return false;
+
+    pthread_mutex_lock(&writer->lock);
+    bool busy = !writer->done;
+    pthread_mutex_unlock(&writer->lock);
+    return busy;
+}
+
+/*
+ * Starts a thread to save the three lists as they are now.
+ * Only the list heads are recorded, so this takes the same time whatever the size of the fleet.
+ * A snapshot that is still being written is never waited for: the new one is refused instead.
+ *
+ * @param writer: The snapshot writer.
+ * @param available_head: Pointer to the head of the available list.
+ * @param rented_head: Pointer to the head of the rented list.
+ * @param repair_head: Pointer to the head of the repair list.
+ * @param available_file: File to save the available list to.
+ * @param rented_file: File to save the rented list to.
+ * @param repair_file: File to save the repair list to.
+ * @return: Returns true if the snapshot was started, false if one is still being written, a file name is too long
+ * or the thread failed to start.
+ */
+bool snapshot_start(struct snapshot_writer *writer, struct car *available_head, struct car *rented_head, struct car *repair_head,
+                    char *available_file, char *rented_file, char *repair_file) {
+    char *files[3] = {available_file, rented_file, repair_file};
+    for (int i = 0; i < 3; i++) {
+        if (strlen(files[i]) >= SNAPSHOT_NAME_LENGTH) return false; // The name would not fit
+    }
+    if (snapshot_busy(writer)) return false;
+    snapshot_wait(writer); // The previous thread has finished, so joining it does not block
+
+    // The thread reads the names after this returns, so keep copies of them
+    for (int i = 0; i < 3; i++) {
+        strcpy(writer->files[i], files[i]);
+    }
+
+    // A new version means no car has been copied for this snapshot yet (0 is left for new cars)
+    writer->version++;
+    if (writer->version == 0) writer->version = 1;
+    writer->heads[0] = available_head;
+    writer->heads[1] = rented_head;
+    writer->heads[2] = repair_head;
+    writer->done = false;
+    writer->lost_copy = false;
+    writer->ok = true;
+
+    if (pthread_create(&writer->thread, NULL, write_snapshot, writer) != 0) return false;
+    writer->running = true;
+    return true;
+}
+
+/*
+ * Waits for the running snapshot to finish and frees the copies kept for it.
+ *
+ * @param writer: The snapshot writer.
+ * @return: Returns true if the last snapshot was saved (or none was running), false otherwise.
+ */
+bool snapshot_wait(struct snapshot_writer *writer) {
+    if (!writer->running) return true;
+
+    pthread_join(writer->thread, NULL);
+    writer->running = false;
+    for (int i = 0; i < SNAPSHOT_BUCKETS; i++) {
+        while (writer->copies[i] != NULL) {
+            struct snapshot_copy *next = writer->copies[i]->next;
+            free(writer->copies[i]);
+            writer->copies[i] = next;
+        }
+    }
+    return writer->ok;
+}
+
+/*
+ * Waits for the running snapshot (if any) and releases the writer's lock.
+ *
+ * @param writer: The snapshot writer.
+ */
+void snapshot_free(struct snapshot_writer *writer) {
+    snapshot_wait(writer);
+    pthread_mutex_destroy(&writer->lock);
+}